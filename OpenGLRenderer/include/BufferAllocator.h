@@ -0,0 +1,232 @@
+#ifndef OPENGLRENDERER_VOXEL_BUFFER_ALLOCATOR_H
+#define OPENGLRENDERER_VOXEL_BUFFER_ALLOCATOR_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "Buffer.h"
+
+
+namespace voxel
+{
+
+/**
+ * Suballocates variable sized blocks from a set of equally sized buffers, called pages.
+ *
+ * Every page keeps a free list of its unused ranges, ordered by offset and merged with their neighbours on release.
+ * Allocations take the first range large enough, in the first page that has one, and a new page is created when none
+ * has. Blocks are referenced by handles rather than offsets, so compact can move them to lower offsets and earlier
+ * pages, which keeps the free ranges large and allows the last pages to be released once they are empty.
+ */
+class BufferAllocator final
+{
+public:
+	/** Type used to represent sizes and offsets [bytes] */
+	using size_type = Buffer::size_type;
+
+	/** Type used to reference an allocated block */
+	using handle_type = std::uint32_t;
+
+	/** Handle returned if an allocation fails */
+	static const handle_type k_uiInvalidHandle = UINT32_MAX;
+
+	/**
+	 * Location of an allocated block
+	 */
+	struct Block
+	{
+		/** Index of the page holding the block */
+		std::uint32_t uiPage;
+
+		/** Offset [bytes] of the block within the page */
+		size_type xOffset;
+
+		/** Size [bytes] of the block, a multiple of the alignment */
+		size_type xSize;
+	};
+
+	/**
+	 * Memory usage and fragmentation of the allocator
+	 */
+	struct Statistics
+	{
+		/** Number of pages */
+		std::size_t uiPageCount = 0;
+
+		/** Size [bytes] of all pages */
+		std::uint64_t uiCapacity = 0;
+
+		/** Size [bytes] of all allocated blocks */
+		std::uint64_t uiUsed = 0;
+
+		/** Number of unused ranges over all pages */
+		std::size_t uiFreeRangeCount = 0;
+
+		/** Size [bytes] of the largest unused range */
+		size_type xLargestFreeRange = 0;
+
+		/** One minus the share of the largest unused range in all unused memory, zero if it is in one piece */
+		float fFragmentation = 0.0f;
+
+		/** Number of blocks moved by compact */
+		std::uint64_t uiMovedBlocks = 0;
+
+		/** Bytes copied by compact */
+		std::uint64_t uiMovedBytes = 0;
+	};
+
+private:
+	/** Size [bytes] of every page */
+	const size_type k_xPageSize;
+
+	/** Alignment [bytes] of the offsets and sizes of all blocks */
+	const size_type k_xAlignment;
+
+	/** Maximum number of pages */
+	const std::uint32_t k_uiMaxPages;
+
+	/** Usage of the pages */
+	const Buffer::Usage k_eUsage;
+
+	/** Pages, only the last one is ever released */
+	std::vector<std::unique_ptr<Buffer>> m_vecPages;
+
+	/** Unused ranges of every page, offset to size */
+	std::vector<std::map<size_type, size_type>> m_vecFreeRanges;
+
+	/** Allocated blocks of every page, offset to handle */
+	std::vector<std::map<size_type, handle_type>> m_vecUsedRanges;
+
+	/** Blocks indexed by their handle */
+	std::vector<Block> m_vecBlocks;
+
+	/** Handles of released blocks, reused by the next allocations */
+	std::vector<handle_type> m_vecFreeHandles;
+
+	/** Size [bytes] of all allocated blocks */
+	std::uint64_t m_uiUsed;
+
+	/** Number of blocks moved by compact */
+	std::uint64_t m_uiMovedBlocks;
+
+	/** Bytes copied by compact */
+	std::uint64_t m_uiMovedBytes;
+
+public:
+	/**
+	 * Creates an allocator without any pages, they are created by the first allocations
+	 *
+	 * @param xPageSize    Size [bytes] of every page, the upper bound for the size of a block
+	 * @param xAlignment   Alignment [bytes] of the offsets and sizes of all blocks
+	 * @param uiMaxPages   Maximum number of pages
+	 * @param eUsage       Usage of the pages
+	 */
+	BufferAllocator(const size_type xPageSize, const size_type xAlignment, const std::uint32_t uiMaxPages, const Buffer::Usage eUsage);
+
+	/**
+	 * Destructor, frees all pages
+	 */
+	~BufferAllocator();
+
+	BufferAllocator(const BufferAllocator&) = delete;
+	BufferAllocator& operator=(const BufferAllocator&) = delete;
+
+	/**
+	 * Allocates a block, creating a new page if no page has room for it
+	 *
+	 * @param xSize  Size [bytes] of the block
+	 * @return handle of the block, k_uiInvalidHandle if the block is larger than a page or all pages are full
+	 */
+	handle_type allocate(const size_type xSize);
+
+	/**
+	 * Releases a block
+	 *
+	 * @param uiHandle  Handle returned by allocate
+	 */
+	void free(const handle_type uiHandle);
+
+	/**
+	 * Writes data to the beginning of a block
+	 *
+	 * @param uiHandle  Handle returned by allocate
+	 * @param pData     Data to write
+	 * @param xSize     Size [bytes] of the data, at most the size of the block
+	 */
+	void upload(const handle_type uiHandle, const void* const pData, const size_type xSize);
+
+	/**
+	 * Copies data from another buffer to the beginning of a block on the GPU, e.g. from a RingBuffer
+	 *
+	 * @param uiHandle         Handle returned by allocate
+	 * @param uiSourceBuffer   Handle to the OpenGL object of the source buffer
+	 * @param xSourceOffset    Offset [bytes] of the data within the source buffer
+	 * @param xSize            Size [bytes] of the data, at most the size of the block
+	 */
+	void copy(const handle_type uiHandle, const std::uint32_t uiSourceBuffer, const size_type xSourceOffset, const size_type xSize);
+
+	/**
+	 * Moves the blocks at the end of the last pages to the first unused ranges large enough to hold them, and
+	 * releases the trailing pages which become empty. Blocks are only copied on the GPU.
+	 * Handles stay valid, but the blocks of moved handles have new locations.
+	 *
+	 * @param xMaxBytes  Upper bound for the bytes to copy
+	 * @return number of bytes copied
+	 */
+	size_type compact(const size_type xMaxBytes);
+
+	/**
+	 * @param uiHandle  Handle returned by allocate
+	 * @return current location of the block
+	 */
+	const Block& block(const handle_type uiHandle) const;
+
+	/**
+	 * @param uiPage  Index of the page
+	 * @return page
+	 */
+	const Buffer& page(const std::uint32_t uiPage) const;
+
+	/**
+	 * @return number of pages
+	 */
+	std::uint32_t pageCount() const;
+
+	/**
+	 * @return memory usage and fragmentation
+	 */
+	Statistics statistics() const;
+
+private:
+	/**
+	 * Takes a range from the free list of a page
+	 *
+	 * @param uiPage       Index of the page
+	 * @param xSize        Aligned size [bytes] of the range
+	 * @param xMaxOffset   Only ranges ending at or before this offset are considered
+	 * @param xOffset      Receives the offset of the range
+	 * @return false if the page has no such range
+	 */
+	bool takeRange(const std::uint32_t uiPage, const size_type xSize, const size_type xMaxOffset, size_type& xOffset);
+
+	/**
+	 * Returns a range to the free list of a page and merges it with the adjacent unused ranges
+	 *
+	 * @param uiPage   Index of the page
+	 * @param xOffset  Offset [bytes] of the range
+	 * @param xSize    Aligned size [bytes] of the range
+	 */
+	void releaseRange(const std::uint32_t uiPage, const size_type xOffset, const size_type xSize);
+
+	/**
+	 * Releases the trailing pages which have no blocks, except the first page
+	 */
+	void releaseEmptyPages();
+};
+
+}
+
+
+#endif
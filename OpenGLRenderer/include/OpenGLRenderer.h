@@ -9,6 +9,7 @@
 namespace voxel
 {
 
+class RingBuffer;
 class Texture;
 
 class COpenGLRenderer final
@@ -17,10 +18,11 @@ private:
 	ImGuiIO* m_pIO;
 
 	std::uint32_t m_uiProgram;
-	std::uint32_t m_uiVBO;
-	std::uint32_t m_uiEBO;
 	std::uint32_t m_uiVAO;
 
+	// Vertices and indices of the GUI, streamed every frame
+	RingBuffer* m_pStreamBuffer;
+
 	Texture* m_xTexture;
 
 public:
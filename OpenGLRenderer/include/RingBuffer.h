@@ -0,0 +1,146 @@
+#ifndef OPENGLRENDERER_VOXEL_RING_BUFFER_H
+#define OPENGLRENDERER_VOXEL_RING_BUFFER_H
+
+#include <cstdint>
+#include <deque>
+
+#include "Buffer.h"
+
+
+// Avoids including GL/glew.h in the header, GLsync is a pointer to this type
+struct __GLsync;
+
+
+namespace voxel
+{
+
+/**
+ * Buffer for data written by the CPU every frame, e.g. draw commands, uniforms or vertices to be copied elsewhere.
+ *
+ * The buffer is mapped persistently and coherently once, so writing needs neither a map call nor an orphaning
+ * glBufferData. Regions are handed out in order and wrap around at the end. Every call of fence inserts a fence
+ * covering the regions handed out since the previous call, and a region is only handed out again once the GPU has
+ * passed the fence covering its previous use. With a buffer large enough for two or three frames of data, the fences
+ * have always been passed and the CPU never waits.
+ *
+ * The GL commands reading a region must be issued before the next region is allocated, as allocate may insert a fence
+ * itself if the current frame fills the whole buffer.
+ */
+class RingBuffer final
+{
+public:
+	/** Type used to represent sizes and offsets [bytes] */
+	using size_type = Buffer::size_type;
+
+	/**
+	 * Synchronization statistics
+	 */
+	struct Statistics
+	{
+		/** Number of fences inserted */
+		std::uint64_t uiFences = 0;
+
+		/** Number of times the CPU had to wait for a fence, as the GPU still read the next region */
+		std::uint64_t uiFenceWaits = 0;
+
+		/** Time [ms] the CPU spent waiting for fences */
+		double dFenceWaitTime = 0.0;
+
+		/** Bytes handed out */
+		std::uint64_t uiAllocatedBytes = 0;
+	};
+
+private:
+	/**
+	 * Fence covering the regions handed out between two calls of fence
+	 */
+	struct Fence
+	{
+		/** GL fence object */
+		__GLsync* pSync;
+
+		/** Bytes covered, including alignment padding and the unused end of the buffer when wrapping around */
+		size_type xSize;
+	};
+
+	/** Size [bytes] of the buffer */
+	const size_type k_xSize;
+
+	/** Handle to the OpenGL object */
+	std::uint32_t m_uiHandle;
+
+	/** Persistently mapped memory of the buffer */
+	std::uint8_t* m_pMemory;
+
+	/** Offset [bytes] of the next region */
+	size_type m_xHead;
+
+	/** Bytes handed out and still possibly read by the GPU, from the oldest fence up to the head */
+	size_type m_xUsed;
+
+	/** Bytes handed out since the last fence */
+	size_type m_xPending;
+
+	/** Fences in the order they were inserted */
+	std::deque<Fence> m_deqFences;
+
+	/** Synchronization statistics */
+	Statistics m_xStatistics;
+
+public:
+	/**
+	 * Creates and persistently maps the buffer
+	 *
+	 * @param xSize  Size [bytes] of the buffer, should hold the data of two to three frames
+	 */
+	explicit RingBuffer(const size_type xSize);
+
+	/**
+	 * Destructor, unmaps and frees the buffer
+	 */
+	~RingBuffer();
+
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+
+	/**
+	 * Hands out the next region, waiting for the GPU to finish reading it if necessary
+	 *
+	 * @param xSize       Size [bytes] of the region
+	 * @param xAlignment  Alignment [bytes] of the offset of the region
+	 * @param xOffset     Receives the offset of the region within the buffer
+	 * @return mapped memory of the region, nullptr if the region is larger than the buffer
+	 */
+	void* allocate(const size_type xSize, const size_type xAlignment, size_type& xOffset);
+
+	/**
+	 * Inserts a fence after the GL commands reading the regions handed out since the last call, usually once per frame
+	 */
+	void fence();
+
+	/**
+	 * @return handle to the OpenGL object, to bind the buffer or regions of it
+	 */
+	std::uint32_t handle() const;
+
+	/**
+	 * @return size of the buffer [bytes]
+	 */
+	size_type size() const;
+
+	/**
+	 * @return synchronization statistics
+	 */
+	const Statistics& statistics() const;
+
+private:
+	/**
+	 * Waits for the oldest fence and releases the regions it covers
+	 */
+	void waitOldestFence();
+};
+
+}
+
+
+#endif
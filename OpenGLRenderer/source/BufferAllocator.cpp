@@ -0,0 +1,366 @@
+#include "BufferAllocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include <GL/glew.h>
+
+using namespace voxel;
+
+
+/**
+ * Creates an allocator without any pages, they are created by the first allocations.
+ *
+ * @param xPageSize    Size [bytes] of every page, the upper bound for the size of a block
+ * @param xAlignment   Alignment [bytes] of the offsets and sizes of all blocks
+ * @param uiMaxPages   Maximum number of pages
+ * @param eUsage       Usage of the pages
+ */
+BufferAllocator::BufferAllocator(const size_type xPageSize, const size_type xAlignment, const std::uint32_t uiMaxPages, const Buffer::Usage eUsage)
+	: k_xPageSize(xPageSize / xAlignment * xAlignment), k_xAlignment(xAlignment), k_uiMaxPages(uiMaxPages), k_eUsage(eUsage),
+	m_uiUsed(0), m_uiMovedBlocks(0), m_uiMovedBytes(0)
+{
+}
+
+
+/**
+ * Destructor, frees all pages
+ */
+BufferAllocator::~BufferAllocator()
+{
+	// Buffer leaves its handle to the owner, see CMesh
+	for (auto& pPage : m_vecPages)
+	{
+		glDeleteBuffers(1, &pPage->m_uiHandle);
+	}
+}
+
+
+/**
+ * Allocates a block, creating a new page if no page has room for it.
+ *
+ * @param xSize  Size [bytes] of the block
+ * @return handle of the block, k_uiInvalidHandle if the block is larger than a page or all pages are full
+ */
+BufferAllocator::handle_type BufferAllocator::allocate(const size_type xSize)
+{
+	if (xSize == 0 || xSize > k_xPageSize)
+	{
+		return k_uiInvalidHandle;
+	}
+	const size_type xAlignedSize = (xSize + k_xAlignment - 1) / k_xAlignment * k_xAlignment;
+
+	Block xBlock;
+	xBlock.xSize = xAlignedSize;
+	bool bFound = false;
+	for (std::uint32_t uiPage = 0; uiPage < pageCount() && !bFound; ++uiPage)
+	{
+		if (takeRange(uiPage, xAlignedSize, k_xPageSize, xBlock.xOffset))
+		{
+			xBlock.uiPage = uiPage;
+			bFound = true;
+		}
+	}
+
+	if (!bFound)
+	{
+		if (pageCount() >= k_uiMaxPages)
+		{
+			return k_uiInvalidHandle;
+		}
+		m_vecPages.emplace_back(new Buffer(k_xPageSize, k_eUsage));
+		m_vecFreeRanges.emplace_back();
+		m_vecFreeRanges.back().emplace(0, k_xPageSize);
+		m_vecUsedRanges.emplace_back();
+		xBlock.uiPage = pageCount() - 1;
+		takeRange(xBlock.uiPage, xAlignedSize, k_xPageSize, xBlock.xOffset);
+	}
+
+	handle_type uiHandle;
+	if (m_vecFreeHandles.empty())
+	{
+		uiHandle = static_cast<handle_type>(m_vecBlocks.size());
+		m_vecBlocks.push_back(xBlock);
+	}
+	else
+	{
+		uiHandle = m_vecFreeHandles.back();
+		m_vecFreeHandles.pop_back();
+		m_vecBlocks[uiHandle] = xBlock;
+	}
+	m_vecUsedRanges[xBlock.uiPage].emplace(xBlock.xOffset, uiHandle);
+	m_uiUsed += xAlignedSize;
+	return uiHandle;
+}
+
+
+/**
+ * Releases a block.
+ *
+ * @param uiHandle  Handle returned by allocate
+ */
+void BufferAllocator::free(const handle_type uiHandle)
+{
+	const Block& xBlock = m_vecBlocks[uiHandle];
+	m_vecUsedRanges[xBlock.uiPage].erase(xBlock.xOffset);
+	releaseRange(xBlock.uiPage, xBlock.xOffset, xBlock.xSize);
+	m_uiUsed -= xBlock.xSize;
+	m_vecFreeHandles.push_back(uiHandle);
+}
+
+
+/**
+ * Writes data to the beginning of a block.
+ * Only the range of the block is mapped and invalidated, so the driver does not need to wait for draws reading the
+ * other blocks of the page.
+ *
+ * @param uiHandle  Handle returned by allocate
+ * @param pData     Data to write
+ * @param xSize     Size [bytes] of the data, at most the size of the block
+ */
+void BufferAllocator::upload(const handle_type uiHandle, const void* const pData, const size_type xSize)
+{
+	const Block& xBlock = m_vecBlocks[uiHandle];
+	const std::uint32_t uiHandleGL = m_vecPages[xBlock.uiPage]->m_uiHandle;
+	void* const pMemory = glMapNamedBufferRange(uiHandleGL, xBlock.xOffset, xSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+	memcpy(pMemory, pData, xSize);
+	glUnmapNamedBuffer(uiHandleGL);
+}
+
+
+/**
+ * Copies data from another buffer to the beginning of a block on the GPU, e.g. from a RingBuffer
+ *
+ * @param uiHandle         Handle returned by allocate
+ * @param uiSourceBuffer   Handle to the OpenGL object of the source buffer
+ * @param xSourceOffset    Offset [bytes] of the data within the source buffer
+ * @param xSize            Size [bytes] of the data, at most the size of the block
+ */
+void BufferAllocator::copy(const handle_type uiHandle, const std::uint32_t uiSourceBuffer, const size_type xSourceOffset, const size_type xSize)
+{
+	const Block& xBlock = m_vecBlocks[uiHandle];
+	glCopyNamedBufferSubData(uiSourceBuffer, m_vecPages[xBlock.uiPage]->m_uiHandle, xSourceOffset, xBlock.xOffset, xSize);
+}
+
+
+/**
+ * Moves the blocks at the end of the last pages to the first unused ranges large enough to hold them, and releases the
+ * trailing pages which become empty.
+ * The copies are queued on the GPU like draw calls, so draws issued before still read the old locations. Only a bounded
+ * number of blocks is looked at per call, so compaction can run every frame and proceeds over several frames.
+ *
+ * @param xMaxBytes  Upper bound for the bytes to copy
+ * @return number of bytes copied
+ */
+BufferAllocator::size_type BufferAllocator::compact(const size_type xMaxBytes)
+{
+	// Nothing to gain if all unused memory is at the end of the last page
+	bool bCompact = true;
+	for (std::uint32_t uiPage = 0; uiPage < pageCount() && bCompact; ++uiPage)
+	{
+		const auto& mapFreeRanges = m_vecFreeRanges[uiPage];
+		if (uiPage + 1 < pageCount())
+		{
+			bCompact = mapFreeRanges.empty();
+		}
+		else
+		{
+			bCompact = mapFreeRanges.empty() || (mapFreeRanges.size() == 1 && mapFreeRanges.begin()->first + mapFreeRanges.begin()->second == k_xPageSize);
+		}
+	}
+	if (bCompact)
+	{
+		return 0;
+	}
+
+	const std::uint32_t k_uiMaxCandidates = 64;
+	std::uint32_t uiCandidates = 0;
+	size_type xCopied = 0;
+	for (std::uint32_t uiPage = pageCount(); uiPage-- > 0 && uiCandidates < k_uiMaxCandidates;)
+	{
+		auto& mapUsedRanges = m_vecUsedRanges[uiPage];
+		auto it = mapUsedRanges.end();
+		while (it != mapUsedRanges.begin() && uiCandidates < k_uiMaxCandidates)
+		{
+			--it;
+			++uiCandidates;
+			const handle_type uiHandle = it->second;
+			Block& xBlock = m_vecBlocks[uiHandle];
+			if (xCopied + xBlock.xSize > xMaxBytes)
+			{
+				uiCandidates = k_uiMaxCandidates;
+				break;
+			}
+
+			// Earlier pages anywhere, the same page only below the block
+			Block xTarget = xBlock;
+			bool bFound = false;
+			for (std::uint32_t uiTargetPage = 0; uiTargetPage <= uiPage && !bFound; ++uiTargetPage)
+			{
+				const size_type xMaxOffset = uiTargetPage == uiPage ? xBlock.xOffset : k_xPageSize;
+				if (takeRange(uiTargetPage, xBlock.xSize, xMaxOffset, xTarget.xOffset))
+				{
+					xTarget.uiPage = uiTargetPage;
+					bFound = true;
+				}
+			}
+			if (!bFound)
+			{
+				continue;
+			}
+
+			glCopyNamedBufferSubData(m_vecPages[xBlock.uiPage]->m_uiHandle, m_vecPages[xTarget.uiPage]->m_uiHandle,
+				xBlock.xOffset, xTarget.xOffset, xBlock.xSize);
+			it = mapUsedRanges.erase(it);
+			releaseRange(xBlock.uiPage, xBlock.xOffset, xBlock.xSize);
+			m_vecUsedRanges[xTarget.uiPage].emplace(xTarget.xOffset, uiHandle);
+			xBlock = xTarget;
+
+			xCopied += xBlock.xSize;
+			m_uiMovedBlocks++;
+			m_uiMovedBytes += xBlock.xSize;
+		}
+	}
+
+	releaseEmptyPages();
+	return xCopied;
+}
+
+
+/**
+ * @param uiHandle  Handle returned by allocate
+ * @return current location of the block
+ */
+const BufferAllocator::Block& BufferAllocator::block(const handle_type uiHandle) const
+{
+	return m_vecBlocks[uiHandle];
+}
+
+
+/**
+ * @param uiPage  Index of the page
+ * @return page
+ */
+const Buffer& BufferAllocator::page(const std::uint32_t uiPage) const
+{
+	return *m_vecPages[uiPage];
+}
+
+
+/**
+ * @return number of pages
+ */
+std::uint32_t BufferAllocator::pageCount() const
+{
+	return static_cast<std::uint32_t>(m_vecPages.size());
+}
+
+
+/**
+ * @return memory usage and fragmentation
+ */
+BufferAllocator::Statistics BufferAllocator::statistics() const
+{
+	Statistics xStatistics;
+	xStatistics.uiPageCount = m_vecPages.size();
+	xStatistics.uiCapacity = static_cast<std::uint64_t>(k_xPageSize) * m_vecPages.size();
+	xStatistics.uiUsed = m_uiUsed;
+	xStatistics.uiMovedBlocks = m_uiMovedBlocks;
+	xStatistics.uiMovedBytes = m_uiMovedBytes;
+
+	std::uint64_t uiFree = 0;
+	for (const auto& mapFreeRanges : m_vecFreeRanges)
+	{
+		xStatistics.uiFreeRangeCount += mapFreeRanges.size();
+		for (const auto& xRange : mapFreeRanges)
+		{
+			uiFree += xRange.second;
+			xStatistics.xLargestFreeRange = std::max(xStatistics.xLargestFreeRange, xRange.second);
+		}
+	}
+	if (uiFree > 0)
+	{
+		xStatistics.fFragmentation = 1.0f - static_cast<float>(static_cast<double>(xStatistics.xLargestFreeRange) / static_cast<double>(uiFree));
+	}
+	return xStatistics;
+}
+
+
+/**
+ * Takes a range from the free list of a page, the first one large enough.
+ *
+ * @param uiPage       Index of the page
+ * @param xSize        Aligned size [bytes] of the range
+ * @param xMaxOffset   Only ranges ending at or before this offset are considered
+ * @param xOffset      Receives the offset of the range
+ * @return false if the page has no such range
+ */
+bool BufferAllocator::takeRange(const std::uint32_t uiPage, const size_type xSize, const size_type xMaxOffset, size_type& xOffset)
+{
+	auto& mapFreeRanges = m_vecFreeRanges[uiPage];
+	for (auto it = mapFreeRanges.begin(); it != mapFreeRanges.end() && it->first + xSize <= xMaxOffset; ++it)
+	{
+		if (it->second < xSize)
+		{
+			continue;
+		}
+
+		xOffset = it->first;
+		const size_type xRemaining = it->second - xSize;
+		mapFreeRanges.erase(it);
+		if (xRemaining > 0)
+		{
+			mapFreeRanges.emplace(xOffset + xSize, xRemaining);
+		}
+		return true;
+	}
+	return false;
+}
+
+
+/**
+ * Returns a range to the free list of a page and merges it with the adjacent unused ranges.
+ *
+ * @param uiPage   Index of the page
+ * @param xOffset  Offset [bytes] of the range
+ * @param xSize    Aligned size [bytes] of the range
+ */
+void BufferAllocator::releaseRange(const std::uint32_t uiPage, const size_type xOffset, const size_type xSize)
+{
+	auto& mapFreeRanges = m_vecFreeRanges[uiPage];
+	auto it = mapFreeRanges.emplace(xOffset, xSize).first;
+
+	const auto itNext = std::next(it);
+	if (itNext != mapFreeRanges.end() && it->first + it->second == itNext->first)
+	{
+		it->second += itNext->second;
+		mapFreeRanges.erase(itNext);
+	}
+
+	if (it != mapFreeRanges.begin())
+	{
+		const auto itPrevious = std::prev(it);
+		if (itPrevious->first + itPrevious->second == it->first)
+		{
+			itPrevious->second += it->second;
+			mapFreeRanges.erase(it);
+		}
+	}
+}
+
+
+/**
+ * Releases the trailing pages which have no blocks, except the first page.
+ * Pages in the middle are kept, removing them would change the page index of the blocks after them.
+ */
+void BufferAllocator::releaseEmptyPages()
+{
+	while (m_vecPages.size() > 1 && m_vecUsedRanges.back().empty())
+	{
+		glDeleteBuffers(1, &m_vecPages.back()->m_uiHandle);
+		m_vecPages.pop_back();
+		m_vecFreeRanges.pop_back();
+		m_vecUsedRanges.pop_back();
+	}
+}
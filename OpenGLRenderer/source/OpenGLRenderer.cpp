@@ -3,8 +3,10 @@
 #endif
 
 #include "OpenGLRenderer.h"
+#include "RingBuffer.h"
 #include "Texture.h"
 
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <string>
@@ -24,12 +26,14 @@ static void errorCallback(const GLenum eSource, const GLenum eType, const GLuint
 
 
 COpenGLRenderer::COpenGLRenderer()
+	: m_pStreamBuffer(nullptr)
 {
 }
 
 
 COpenGLRenderer::~COpenGLRenderer()
 {
+	delete m_pStreamBuffer;
 }
 
 
@@ -146,19 +150,21 @@ void COpenGLRenderer::initialize()
 		glLinkProgram(m_uiProgram);
 		checkProgram(m_uiProgram);
 
-	glGenBuffers(1, &m_uiVBO);
-		glBindBuffer(GL_ARRAY_BUFFER, m_uiVBO);
-	glGenBuffers(1, &m_uiEBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_uiEBO);
+	// Room for a few frames of GUI geometry, the vertex buffer binding moves through it
+	m_pStreamBuffer = new RingBuffer(4 * 1024 * 1024);
 
 	glCreateVertexArrays(1, &m_uiVAO);
 		glBindVertexArray(m_uiVAO);
 		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), reinterpret_cast<void*>(offsetof(ImDrawVert, pos)));
+		glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, offsetof(ImDrawVert, pos));
+		glVertexAttribBinding(0, 0);
 		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), reinterpret_cast<void*>(offsetof(ImDrawVert, uv)));
+		glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, offsetof(ImDrawVert, uv));
+		glVertexAttribBinding(1, 0);
 		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), reinterpret_cast<void*>(offsetof(ImDrawVert, col)));
+		glVertexAttribFormat(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(ImDrawVert, col));
+		glVertexAttribBinding(2, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pStreamBuffer->handle());
 	glBindVertexArray(0);
 
 	ImGui::StyleColorsDark();
@@ -233,16 +239,24 @@ void COpenGLRenderer::renderGui(ImDrawData* const pDrawData)
 		glUniformMatrix4fv(glGetUniformLocation(m_uiProgram, "ProjMtx"), 1, GL_FALSE, glm::value_ptr(xOrtho));
 
 	glBindVertexArray(m_uiVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_uiVBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_uiEBO);
 
 	for(std::int32_t iCommandList = 0; iCommandList < pDrawData->CmdListsCount; ++iCommandList)
 	{
 		const ImDrawList* const cmd_list = pDrawData->CmdLists[iCommandList];
-		const ImDrawIdx* pIndexBufferOffset = 0;
 
-		glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert), (const GLvoid*)cmd_list->VtxBuffer.Data, GL_STREAM_DRAW);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx), (const GLvoid*)cmd_list->IdxBuffer.Data, GL_STREAM_DRAW);
+		// Vertices and indices share one region, the indices follow the vertices
+		const RingBuffer::size_type xVertexBytes = cmd_list->VtxBuffer.Size * sizeof(ImDrawVert);
+		const RingBuffer::size_type xIndexBytes = cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx);
+		RingBuffer::size_type xOffset = 0;
+		std::uint8_t* const pMemory = static_cast<std::uint8_t*>(m_pStreamBuffer->allocate(xVertexBytes + xIndexBytes, sizeof(ImDrawVert), xOffset));
+		if(pMemory == nullptr)
+		{
+			continue;
+		}
+		memcpy(pMemory, cmd_list->VtxBuffer.Data, xVertexBytes);
+		memcpy(pMemory + xVertexBytes, cmd_list->IdxBuffer.Data, xIndexBytes);
+		glBindVertexBuffer(0, m_pStreamBuffer->handle(), xOffset, sizeof(ImDrawVert));
+		const ImDrawIdx* pIndexBufferOffset = reinterpret_cast<const ImDrawIdx*>(static_cast<std::uintptr_t>(xOffset + xVertexBytes));
 
 		for(std::int32_t iCommand = 0; iCommand < cmd_list->CmdBuffer.Size; ++iCommand)
 		{
@@ -260,6 +274,8 @@ void COpenGLRenderer::renderGui(ImDrawData* const pDrawData)
 		}
 	}
 
+	m_pStreamBuffer->fence();
+
 	glDisable(GL_BLEND);
 	glEnable(GL_CULL_FACE);
 	glEnable(GL_DEPTH_TEST);
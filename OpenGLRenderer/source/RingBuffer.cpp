@@ -0,0 +1,166 @@
+#include "RingBuffer.h"
+
+#include <chrono>
+
+#include <GL/glew.h>
+
+using namespace voxel;
+
+
+/**
+ * Creates and persistently maps the buffer.
+ * The mapping is coherent, so writes become visible to the GPU without explicit flushes.
+ *
+ * @param xSize  Size [bytes] of the buffer, should hold the data of two to three frames
+ */
+RingBuffer::RingBuffer(const size_type xSize)
+	: k_xSize(xSize), m_uiHandle(0), m_pMemory(nullptr), m_xHead(0), m_xUsed(0), m_xPending(0)
+{
+	const GLbitfield xFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &m_uiHandle);
+	glNamedBufferStorage(m_uiHandle, k_xSize, nullptr, xFlags);
+	m_pMemory = static_cast<std::uint8_t*>(glMapNamedBufferRange(m_uiHandle, 0, k_xSize, xFlags));
+}
+
+
+/**
+ * Destructor, unmaps and frees the buffer
+ */
+RingBuffer::~RingBuffer()
+{
+	for (const auto& xFence : m_deqFences)
+	{
+		glDeleteSync(xFence.pSync);
+	}
+	glUnmapNamedBuffer(m_uiHandle);
+	glDeleteBuffers(1, &m_uiHandle);
+}
+
+
+/**
+ * Hands out the next region, waiting for the GPU to finish reading it if necessary.
+ * If the regions handed out since the last fence fill the whole buffer, a fence is inserted for them, so the GL commands
+ * reading them must have been issued already.
+ *
+ * @param xSize       Size [bytes] of the region
+ * @param xAlignment  Alignment [bytes] of the offset of the region
+ * @param xOffset     Receives the offset of the region within the buffer
+ * @return mapped memory of the region, nullptr if the region is larger than the buffer
+ */
+void* RingBuffer::allocate(const size_type xSize, const size_type xAlignment, size_type& xOffset)
+{
+	if (xSize > k_xSize)
+	{
+		return nullptr;
+	}
+
+	size_type xOffsetAligned;
+	size_type xConsumed;
+	for (;;)
+	{
+		// Nothing is in flight, start over at the beginning so the region never has to wrap around
+		if (m_xUsed == 0)
+		{
+			m_xHead = 0;
+		}
+
+		// Bytes skipped for the alignment, or up to the end of the buffer if the region does not fit before it
+		xOffsetAligned = (m_xHead + xAlignment - 1) / xAlignment * xAlignment;
+		if (xOffsetAligned > k_xSize - xSize)
+		{
+			xOffsetAligned = 0;
+		}
+		xConsumed = (xOffsetAligned >= m_xHead ? xOffsetAligned - m_xHead : k_xSize - m_xHead) + xSize;
+		if (m_xUsed + xConsumed <= k_xSize)
+		{
+			break;
+		}
+
+		if (m_deqFences.empty())
+		{
+			fence();
+		}
+		waitOldestFence();
+	}
+
+	xOffset = xOffsetAligned;
+	m_xHead = xOffsetAligned + xSize;
+	m_xUsed += xConsumed;
+	m_xPending += xConsumed;
+	m_xStatistics.uiAllocatedBytes += xSize;
+	return m_pMemory + xOffset;
+}
+
+
+/**
+ * Inserts a fence after the GL commands reading the regions handed out since the last call, usually once per frame
+ */
+void RingBuffer::fence()
+{
+	if (m_xPending == 0)
+	{
+		return;
+	}
+	Fence xFence;
+	xFence.pSync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	xFence.xSize = m_xPending;
+	m_deqFences.push_back(xFence);
+	m_xPending = 0;
+	m_xStatistics.uiFences++;
+}
+
+
+/**
+ * @return handle to the OpenGL object, to bind the buffer or regions of it
+ */
+std::uint32_t RingBuffer::handle() const
+{
+	return m_uiHandle;
+}
+
+
+/**
+ * @return size of the buffer [bytes]
+ */
+RingBuffer::size_type RingBuffer::size() const
+{
+	return k_xSize;
+}
+
+
+/**
+ * @return synchronization statistics
+ */
+const RingBuffer::Statistics& RingBuffer::statistics() const
+{
+	return m_xStatistics;
+}
+
+
+/**
+ * Waits for the oldest fence and releases the regions it covers.
+ * Fences the GPU has already passed are released without counting a wait.
+ */
+void RingBuffer::waitOldestFence()
+{
+	const Fence xFence = m_deqFences.front();
+	m_deqFences.pop_front();
+
+	GLenum eResult = glClientWaitSync(xFence.pSync, 0, 0);
+	if (eResult == GL_TIMEOUT_EXPIRED)
+	{
+		m_xStatistics.uiFenceWaits++;
+		const auto xStart = std::chrono::steady_clock::now();
+		// The first wait flushes, so the fence is guaranteed to be signaled eventually
+		GLbitfield xFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		do
+		{
+			eResult = glClientWaitSync(xFence.pSync, xFlags, 1000000);
+			xFlags = 0;
+		} while (eResult == GL_TIMEOUT_EXPIRED);
+		m_xStatistics.dFenceWaitTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - xStart).count();
+	}
+
+	glDeleteSync(xFence.pSync);
+	m_xUsed -= xFence.xSize;
+}
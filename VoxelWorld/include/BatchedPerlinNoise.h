@@ -0,0 +1,71 @@
+#ifndef BATCHED_PERLIN_NOISE_H
+#define BATCHED_PERLIN_NOISE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "PerlinNoise.h"
+
+
+/**
+ * 2D octave Perlin noise evaluated for many sample points at once.
+ *
+ * Produces the same values as siv::PerlinNoise::octaveNoise0_1(x, y, octaves) with the same seed. On CPUs supporting
+ * AVX2 four samples are evaluated per instruction, otherwise the scalar implementation is used. Both paths perform the
+ * same IEEE operations in the same order, so their results are identical; callers may rely on a difference of at most
+ * k_dTolerance between the two.
+ */
+class BatchedPerlinNoise final
+{
+public:
+	/** Maximum difference between the results of the SIMD and the scalar implementation */
+	static constexpr double k_dTolerance = 1e-12;
+
+private:
+	/** Scalar implementation, also the reference for the SIMD one */
+	siv::PerlinNoise m_xNoise;
+
+	/** Permutation table of m_xNoise, widened to 32 bit for gathers */
+	std::int32_t m_arrPermutation[512];
+
+	/** Whether the SIMD implementation is used, if supported */
+	std::atomic<bool> m_bSimdEnabled;
+
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param uiSeed  Seed of the permutation table
+	 */
+	explicit BatchedPerlinNoise(const std::uint32_t uiSeed);
+
+	/**
+	 * Evaluates octaveNoise0_1 for a batch of sample points. Thread safe.
+	 *
+	 * @param pX         X coordinates of the sample points
+	 * @param pY         Y coordinates of the sample points
+	 * @param pResult    Receives the noise values in [0, 1]
+	 * @param uiCount    Number of sample points
+	 * @param iOctaves   Number of octaves
+	 */
+	void octaveNoise0_1(const double* pX, const double* pY, double* pResult, const std::size_t uiCount, const std::int32_t iOctaves) const;
+
+	/**
+	 * Selects whether the SIMD implementation is used when the CPU supports it
+	 */
+	void setSimdEnabled(const bool bEnabled);
+
+	/**
+	 * @return whether the SIMD implementation is currently used
+	 */
+	bool isSimdActive() const;
+
+	/**
+	 * @return whether the CPU supports the SIMD implementation
+	 */
+	static bool isSimdSupported();
+};
+
+
+#endif // !BATCHED_PERLIN_NOISE_H
@@ -0,0 +1,56 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <array>
+
+
+/**
+ * View frustum as six planes extracted from a view projection matrix
+ */
+class Frustum final
+{
+public:
+	/**
+	 * Position of a box relative to the frustum
+	 */
+	enum class Containment
+	{
+		/** The box is completely outside, or at least outside one plane */
+		eOutside,
+		/** The box intersects the frustum */
+		eIntersecting,
+		/** The box is completely inside */
+		eInside,
+	};
+
+private:
+	/**
+	 * Planes (a, b, c, d) with normals pointing inwards, a point p is inside if dot(p, (a, b, c)) + d >= 0.
+	 * In the order left, right, bottom, top, near, far.
+	 */
+	std::array<glm::vec4, 6> m_arrPlanes;
+
+public:
+	/**
+	 * Extracts the planes of the frustum
+	 *
+	 * @param xViewProjection  Matrix transforming world coordinates into OpenGL clip space
+	 */
+	explicit Frustum(const glm::mat4& xViewProjection);
+
+	/**
+	 * Tests an axis aligned box against the frustum. The test is conservative: boxes near the corners of the frustum
+	 * might be reported as intersecting although they are outside.
+	 *
+	 * @param xMin  Minimum corner of the box in world coordinates
+	 * @param xMax  Maximum corner of the box in world coordinates
+	 */
+	Containment classify(const glm::vec3& xMin, const glm::vec3& xMax) const;
+};
+
+
+#endif // !FRUSTUM_H
@@ -1,3 +1,5 @@
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <list>
 #include <map>
@@ -6,33 +8,141 @@
 
 
 /*
- * An unordered_map like datastructure with a limited capacity.
- * If capacity is reached, the first inserted item is removed from the map.
+ * An unordered_map like datastructure with a limited capacity, evicting the least recently used items.
+ * Every item has a cost, one by default, and items are evicted once their total cost exceeds the limit. The most
+ * recently used item is kept even if its cost alone exceeds the limit.
+ * get and set are O(1): the items live in a list ordered by recency, which the map points into.
  */
 template <typename Key, typename Value> class LimitedUnorderedMap {
+public:
+    using CostFunction = std::function<std::size_t(const Value&)>;
+    using EvictionCallback = std::function<void(const Key&, const std::shared_ptr<Value>&)>;
+
+    struct Statistics {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+    };
+
 private:
-    std::unordered_map<Key, std::shared_ptr<Value>> map;
-    std::list<Key> list;
+    struct Entry {
+        Key key;
+        std::shared_ptr<Value> value;
+        std::size_t cost;
+    };
+
+    // most recently used first
+    std::list<Entry> list;
+    std::unordered_map<Key, typename std::list<Entry>::iterator> map;
     std::size_t limit;
+    std::size_t totalCost = 0;
+    CostFunction costFunction;
+    EvictionCallback evictionCallback;
+    Statistics statistics;
+
+    void evict() {
+        while (totalCost > limit && list.size() > 1) {
+            evictLeastRecent();
+        }
+    }
 
 public:
-    LimitedUnorderedMap(const std::size_t limit) : limit(limit) {}
+    // Without a cost function every item costs one, so limit is the number of items
+    LimitedUnorderedMap(const std::size_t limit, CostFunction costFunction = CostFunction(),
+                        EvictionCallback evictionCallback = EvictionCallback())
+        : limit(limit), costFunction(costFunction), evictionCallback(evictionCallback) {}
 
-    std::shared_ptr<Value> get(const Key& key) const {
+    // Returns the item and marks it as most recently used
+    std::shared_ptr<Value> get(const Key& key) {
+        auto entry = map.find(key);
+        if (entry == map.end()) {
+            statistics.misses++;
+            return std::shared_ptr<Value>();
+        }
+        statistics.hits++;
+        list.splice(list.begin(), list, entry->second);
+        return entry->second->value;
+    }
+
+    // Returns the item without affecting the eviction order or the statistics
+    std::shared_ptr<Value> peek(const Key& key) const {
         auto entry = map.find(key);
         if (entry != map.end()) {
-            return entry->second;
+            return entry->second->value;
         }
         return std::shared_ptr<Value>();
     }
 
+    // Inserts or replaces the item and marks it as most recently used
     void set(const Key& key, std::shared_ptr<Value> value) {
-        map[key] = value;
-        list.push_front(key);
-        if (list.size() > limit) {
-            Key keyToRemove = list.back();
-            map.erase(keyToRemove);
-            list.pop_back();
+        const std::size_t cost = costFunction ? costFunction(*value) : 1;
+        auto entry = map.find(key);
+        if (entry != map.end()) {
+            totalCost -= entry->second->cost;
+            entry->second->value = value;
+            entry->second->cost = cost;
+            list.splice(list.begin(), list, entry->second);
+        } else {
+            list.push_front(Entry{key, value, cost});
+            map.emplace(key, list.begin());
+        }
+        totalCost += cost;
+        evict();
+    }
+
+    // Evicts the least recently used item, returns false if the map is empty
+    bool evictLeastRecent() {
+        if (list.empty()) {
+            return false;
+        }
+        Entry entry = std::move(list.back());
+        list.pop_back();
+        map.erase(entry.key);
+        totalCost -= entry.cost;
+        statistics.evictions++;
+        if (evictionCallback) {
+            evictionCallback(entry.key, entry.value);
         }
+        return true;
+    }
+
+    // Removes the item without invoking the eviction callback
+    bool erase(const Key& key) {
+        auto entry = map.find(key);
+        if (entry == map.end()) {
+            return false;
+        }
+        totalCost -= entry->second->cost;
+        list.erase(entry->second);
+        map.erase(entry);
+        return true;
+    }
+
+    // Removes all items without invoking the eviction callback
+    void clear() {
+        map.clear();
+        list.clear();
+        totalCost = 0;
+    }
+
+    void setLimit(const std::size_t newLimit) {
+        limit = newLimit;
+        evict();
+    }
+
+    std::size_t getLimit() const {
+        return limit;
+    }
+
+    std::size_t size() const {
+        return map.size();
+    }
+
+    std::size_t getTotalCost() const {
+        return totalCost;
+    }
+
+    const Statistics& getStatistics() const {
+        return statistics;
     }
 };
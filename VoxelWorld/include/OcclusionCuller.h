@@ -0,0 +1,114 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * Software occlusion culling against a low resolution depth buffer, entirely on the CPU.
+ *
+ * Solid boxes are rasterized into the depth buffer as occluders, then a hierarchy of lower resolutions is built where
+ * every texel holds the farthest depth of the four texels below it. A box is occluded if its nearest depth is behind
+ * the depth buffer everywhere it covers, which is tested on the level where it covers only a few texels.
+ *
+ * The test never culls a visible box: occluders only cover pixels they cover completely, with the farthest depth
+ * they have within the pixel, and boxes are tested with their nearest corner. Depths are normalized device depths
+ * mapped to [0, 1], with 1 being the far plane.
+ */
+class OcclusionCuller final
+{
+public:
+	/** Width of the depth buffer [pixels], a multiple of four */
+	static const int k_iWidth = 256;
+
+	/** Height of the depth buffer [pixels] */
+	static const int k_iHeight = 128;
+
+private:
+	/**
+	 * Vertex of an occluder triangle in clip space
+	 */
+	using ClipVertex = glm::vec4;
+
+	/**
+	 * Matrix transforming world coordinates into clip space
+	 */
+	glm::mat4 m_xViewProjection;
+
+	/**
+	 * Depth buffer and the levels of the hierarchy, level 0 has the full resolution and each following level half the
+	 * resolution of the previous one
+	 */
+	std::vector<std::vector<float>> m_vecLevels;
+
+	/**
+	 * Number of triangles rasterized since begin
+	 */
+	std::size_t m_uiTriangles;
+
+public:
+	/**
+	 * Allocates the depth buffer
+	 */
+	OcclusionCuller();
+
+	/**
+	 * Clears the depth buffer to the far plane
+	 *
+	 * @param xViewProjection  Matrix transforming world coordinates into OpenGL clip space
+	 */
+	void begin(const glm::mat4& xViewProjection);
+
+	/**
+	 * Rasterizes the faces of a box into the depth buffer. The box must be solid.
+	 *
+	 * @param xMin  Minimum corner of the box in world coordinates
+	 * @param xMax  Maximum corner of the box in world coordinates
+	 */
+	void addOccluder(const glm::vec3& xMin, const glm::vec3& xMax);
+
+	/**
+	 * Builds the hierarchy of the depth buffer, must be called after the last occluder and before the first test
+	 */
+	void finishOccluders();
+
+	/**
+	 * Tests whether a box is hidden behind the occluders. Boxes crossing the near plane are never occluded.
+	 *
+	 * @param xMin  Minimum corner of the box in world coordinates
+	 * @param xMax  Maximum corner of the box in world coordinates
+	 */
+	bool isOccluded(const glm::vec3& xMin, const glm::vec3& xMax) const;
+
+	/**
+	 * @return number of triangles rasterized since begin, after back face culling and clipping
+	 */
+	std::size_t getTriangleCount() const;
+
+private:
+	/**
+	 * Clips a triangle against the near plane and rasterizes the remaining part
+	 *
+	 * @param xA  First vertex in clip space
+	 * @param xB  Second vertex in clip space
+	 * @param xC  Third vertex in clip space, counter-clockwise when seen from outside the box
+	 */
+	void clipTriangle(const ClipVertex& xA, const ClipVertex& xB, const ClipVertex& xC);
+
+	/**
+	 * Rasterizes a triangle in front of the near plane, skipping it if it faces away from the camera
+	 *
+	 * @param xA  First vertex in clip space
+	 * @param xB  Second vertex in clip space
+	 * @param xC  Third vertex in clip space
+	 */
+	void rasterizeTriangle(const ClipVertex& xA, const ClipVertex& xB, const ClipVertex& xC);
+};
+
+
+#endif // !OCCLUSION_CULLER_H
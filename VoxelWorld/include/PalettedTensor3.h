@@ -0,0 +1,199 @@
+#ifndef PALETTED_TENSOR3_H
+#define PALETTED_TENSOR3_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "Tensor3.h"
+
+/*
+ * A Tensor3 of chars which stores every distinct value once in a palette and the elements as bit-packed indices into
+ * it. Indices use 0, 1, 2, 4 or 8 bits, whichever is enough for the size of the palette, so they never straddle two
+ * words. The elements are ordered like in Tensor3, with the last coordinate being contiguous.
+ */
+template <int dim1, int dim2, int dim3> class PalettedTensor3 {
+    static const int size = dim1 * dim2 * dim3;
+
+    std::vector<char> palette;
+    std::vector<std::uint64_t> words;
+    int bits = 0;
+
+    static int linearIndex(const int x, const int y, const int z) {
+        return (x * dim2 + y) * dim3 + z;
+    }
+
+    static int bitsFor(const std::size_t paletteSize) {
+        if (paletteSize <= 1) {
+            return 0;
+        }
+        if (paletteSize <= 2) {
+            return 1;
+        }
+        if (paletteSize <= 4) {
+            return 2;
+        }
+        if (paletteSize <= 16) {
+            return 4;
+        }
+        return 8;
+    }
+
+    unsigned index(const int i) const {
+        if (bits == 0) {
+            return 0;
+        }
+        const int perWord = 64 / bits;
+        const std::uint64_t word = words[static_cast<std::size_t>(i / perWord)];
+        const std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+        return static_cast<unsigned>((word >> ((i % perWord) * bits)) & mask);
+    }
+
+    void setIndex(const int i, const unsigned paletteIndex) {
+        if (bits == 0) {
+            return;
+        }
+        const int perWord = 64 / bits;
+        std::uint64_t& word = words[static_cast<std::size_t>(i / perWord)];
+        const int shift = (i % perWord) * bits;
+        const std::uint64_t mask = (std::uint64_t(1) << bits) - 1;
+        word = (word & ~(mask << shift)) | (std::uint64_t(paletteIndex) << shift);
+    }
+
+    // repacks the indices with the given number of bits
+    void resize(const int newBits) {
+        std::vector<unsigned> indices(size);
+        for (int i = 0; i < size; i++) {
+            indices[static_cast<std::size_t>(i)] = index(i);
+        }
+        bits = newBits;
+        words.assign(bits == 0 ? 0 : static_cast<std::size_t>(size / (64 / bits)), 0);
+        for (int i = 0; i < size; i++) {
+            setIndex(i, indices[static_cast<std::size_t>(i)]);
+        }
+    }
+
+    // decodes count elements starting at the first element of a word
+    template <int wordBits> void decodeWords(const int first, const int count, char* out) const {
+        const int perWord = 64 / wordBits;
+        const std::uint64_t mask = (std::uint64_t(1) << wordBits) - 1;
+        for (int i = 0; i < count; i += perWord) {
+            std::uint64_t word = words[static_cast<std::size_t>((first + i) / perWord)];
+            const int n = std::min(perWord, count - i);
+            for (int j = 0; j < n; j++) {
+                out[i + j] = palette[word & mask];
+                word >>= wordBits;
+            }
+        }
+    }
+
+public:
+    // All elements are zero
+    PalettedTensor3() : palette(1, 0) {}
+
+    explicit PalettedTensor3(const Tensor3<char, dim1, dim2, dim3>& dense) : PalettedTensor3(dense, 0, 0, 0) {}
+
+    // Compresses the block of a larger dense tensor which starts at the given offset
+    template <class Dense> PalettedTensor3(const Dense& dense, const int offsetX, const int offsetY, const int offsetZ) {
+        unsigned lookup[256];
+        std::fill(std::begin(lookup), std::end(lookup), 256u);
+        for (int x = 0; x < dim1; x++) {
+            for (int y = 0; y < dim2; y++) {
+                for (int z = 0; z < dim3; z++) {
+                    const char value = dense(offsetX + x, offsetY + y, offsetZ + z);
+                    unsigned& paletteIndex = lookup[static_cast<unsigned char>(value)];
+                    if (paletteIndex == 256u) {
+                        paletteIndex = static_cast<unsigned>(palette.size());
+                        palette.push_back(value);
+                    }
+                }
+            }
+        }
+
+        bits = bitsFor(palette.size());
+        words.assign(bits == 0 ? 0 : static_cast<std::size_t>(size / (64 / bits)), 0);
+        for (int x = 0; x < dim1; x++) {
+            for (int y = 0; y < dim2; y++) {
+                for (int z = 0; z < dim3; z++) {
+                    setIndex(linearIndex(x, y, z),
+                             lookup[static_cast<unsigned char>(dense(offsetX + x, offsetY + y, offsetZ + z))]);
+                }
+            }
+        }
+    }
+
+    char operator()(const int x, const int y, const int z) const {
+        return palette[index(linearIndex(x, y, z))];
+    }
+
+    void set(const int x, const int y, const int z, const char value) {
+        auto entry = std::find(palette.begin(), palette.end(), value);
+        const unsigned paletteIndex = static_cast<unsigned>(entry - palette.begin());
+        if (entry == palette.end()) {
+            palette.push_back(value);
+            if (bitsFor(palette.size()) != bits) {
+                resize(bitsFor(palette.size()));
+            }
+        }
+        setIndex(linearIndex(x, y, z), paletteIndex);
+    }
+
+    // Writes the dim3 elements at (x, y, 0) to (x, y, dim3 - 1) to out
+    void decodeRow(const int x, const int y, char* out) const {
+        decode(linearIndex(x, y, 0), dim3, out);
+    }
+
+    // Writes all elements to out, in the order of Tensor3
+    void decodeAll(char* out) const {
+        decode(0, size, out);
+    }
+
+    // Writes count consecutive elements starting at the linear index first to out. If first does not start a word, the
+    // slower per element access is used.
+    void decode(const int first, const int count, char* out) const {
+        if (bits != 0 && first % (64 / bits) != 0) {
+            for (int i = 0; i < count; i++) {
+                out[i] = palette[index(first + i)];
+            }
+            return;
+        }
+        switch (bits) {
+        case 0:
+            std::fill(out, out + count, palette[0]);
+            break;
+        case 1:
+            decodeWords<1>(first, count, out);
+            break;
+        case 2:
+            decodeWords<2>(first, count, out);
+            break;
+        case 4:
+            decodeWords<4>(first, count, out);
+            break;
+        default:
+            decodeWords<8>(first, count, out);
+            break;
+        }
+    }
+
+    // True if the tensor is stored as a single value without any indices, i.e. all elements are equal
+    bool isUniform() const {
+        return palette.size() == 1;
+    }
+
+    std::size_t paletteSize() const {
+        return palette.size();
+    }
+
+    int bitsPerElement() const {
+        return bits;
+    }
+
+    // Memory used by the tensor, including its heap allocations
+    std::size_t byteSize() const {
+        return sizeof(*this) + palette.capacity() + words.capacity() * sizeof(std::uint64_t);
+    }
+};
+
+#endif // !PALETTED_TENSOR3_H
@@ -12,6 +12,8 @@
 #include "Mesh.h"
 #include "ShaderProgram.h"
 
+class WorldRenderer;
+
 class RenderLoop {
 public:
     void init();
@@ -26,6 +28,7 @@ private:
     void initCamera();
 
     void handleInput();
+    void governRenderDistance(WorldRenderer& worldRenderer, float averageFrameTime);
 
     void mouseCursorPositionCallback(double xPosition, double yPosition);
     void mouseScrollCallback(double xOffset, double yOffset);
@@ -42,6 +45,11 @@ private:
     float lastFrame = 0.0f;
     float deltaTime = 0.0f;
 
+    // render distance governor, changes the render distance by one chunk at a time to keep the frame time near the
+    // target. After a change, it waits until the averaged frame times were all taken with the new distance.
+    bool adaptiveRenderDistance = true;
+    std::uint32_t framesSinceRenderDistanceChange = 0;
+
     // camera
     float cameraSpeed = 2.0f;
 
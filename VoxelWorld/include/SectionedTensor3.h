@@ -0,0 +1,132 @@
+#ifndef SECTIONED_TENSOR3_H
+#define SECTIONED_TENSOR3_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "PalettedTensor3.h"
+
+/*
+ * A Tensor3 of chars split along the second dimension into sections of sectionHeight layers. Every section is
+ * palette compressed on its own, so a section in which all elements are equal, like the air above the terrain or the
+ * ground below it, only stores that one value.
+ * For every column along the second dimension it keeps the extent of the non-zero elements, a height map of the
+ * terrain when zero is air.
+ */
+template <int dim1, int dim2, int dim3, int sectionHeight> class SectionedTensor3 {
+    static_assert(dim2 % sectionHeight == 0, "The height must be a multiple of the section height");
+    static_assert(dim2 <= 255, "Column extents are stored in 8 bits");
+
+public:
+    static const int sectionCount = dim2 / sectionHeight;
+
+    using Section = PalettedTensor3<dim1, sectionHeight, dim3>;
+
+private:
+    Section sections[sectionCount];
+
+    // per column, the number of non-zero elements from the bottom up to the first zero element
+    std::uint8_t floors[dim1][dim3] = {};
+
+    // per column, one more than the index of the highest non-zero element, zero if all elements are zero
+    std::uint8_t tops[dim1][dim3] = {};
+
+    std::uint8_t minFloor = 0;
+    std::uint8_t maxTop = 0;
+
+    template <class Column> void updateColumn(const int x, const int z, const Column& column) {
+        int floor = 0;
+        while (floor < dim2 && column(floor) != 0) {
+            floor++;
+        }
+        int top = dim2;
+        while (top > floor && column(top - 1) == 0) {
+            top--;
+        }
+        floors[x][z] = static_cast<std::uint8_t>(floor);
+        tops[x][z] = static_cast<std::uint8_t>(top);
+    }
+
+    void updateExtents() {
+        minFloor = *std::min_element(&floors[0][0], &floors[0][0] + dim1 * dim3);
+        maxTop = *std::max_element(&tops[0][0], &tops[0][0] + dim1 * dim3);
+    }
+
+public:
+    // All elements are zero
+    SectionedTensor3() = default;
+
+    // Compresses the lowest filledSections sections of the dense tensor, the ones above are known to be zero
+    explicit SectionedTensor3(const Tensor3<char, dim1, dim2, dim3>& dense, const int filledSections = sectionCount) {
+        for (int s = 0; s < filledSections; s++) {
+            sections[s] = Section(dense, 0, s * sectionHeight, 0);
+        }
+        for (int x = 0; x < dim1; x++) {
+            for (int z = 0; z < dim3; z++) {
+                updateColumn(x, z, [&dense, x, z](const int y) { return dense(x, y, z); });
+            }
+        }
+        updateExtents();
+    }
+
+    char operator()(const int x, const int y, const int z) const {
+        return sections[y / sectionHeight](x, y % sectionHeight, z);
+    }
+
+    void set(const int x, const int y, const int z, const char value) {
+        sections[y / sectionHeight].set(x, y % sectionHeight, z, value);
+        updateColumn(x, z, [this, x, z](const int columnY) { return (*this)(x, columnY, z); });
+        updateExtents();
+    }
+
+    // Writes the dim3 elements at (x, y, 0) to (x, y, dim3 - 1) to out
+    void decodeRow(const int x, const int y, char* out) const {
+        sections[y / sectionHeight].decodeRow(x, y % sectionHeight, out);
+    }
+
+    const Section& section(const int s) const {
+        return sections[s];
+    }
+
+    // True if all elements of the section are stored as a single value, see uniformValue
+    bool isSectionUniform(const int s) const {
+        return sections[s].isUniform();
+    }
+
+    // Value of all elements of a uniform section
+    char uniformValue(const int s) const {
+        return sections[s](0, 0, 0);
+    }
+
+    // Number of non-zero elements at the bottom of the column (x, z), below its first zero element
+    int columnFloor(const int x, const int z) const {
+        return floors[x][z];
+    }
+
+    // One more than the second coordinate of the highest non-zero element of the column (x, z), zero if there is none
+    int columnTop(const int x, const int z) const {
+        return tops[x][z];
+    }
+
+    // Minimum of the column floors
+    int getMinFloor() const {
+        return minFloor;
+    }
+
+    // Maximum of the column tops
+    int getMaxTop() const {
+        return maxTop;
+    }
+
+    // Memory used by the tensor, including the heap allocations of its sections
+    std::size_t byteSize() const {
+        std::size_t bytes = sizeof(*this);
+        for (const auto& s : sections) {
+            bytes += s.byteSize() - sizeof(s);
+        }
+        return bytes;
+    }
+};
+
+#endif // !SECTIONED_TENSOR3_H
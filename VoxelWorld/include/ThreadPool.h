@@ -0,0 +1,96 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Fixed set of worker threads executing tasks in submission order
+ */
+class ThreadPool final
+{
+private:
+	/**
+	 * Worker threads
+	 */
+	std::vector<std::thread> m_vecThreads;
+
+	/**
+	 * Tasks waiting for a free worker
+	 */
+	std::deque<std::function<void()>> m_deqTasks;
+
+	/**
+	 * Guards the task queue and the stop flag
+	 */
+	std::mutex m_xMutex;
+
+	/**
+	 * Signalled when a task was queued or the pool is stopping
+	 */
+	std::condition_variable m_xCondition;
+
+	/**
+	 * Set when the pool is being destroyed
+	 */
+	bool m_bStop;
+
+public:
+	/**
+	 * Starts the worker threads
+	 *
+	 * @param uiThreads  Number of worker threads, at least one thread is started
+	 */
+	explicit ThreadPool(const std::size_t uiThreads);
+
+	/**
+	 * Destructor
+	 * Drops the tasks which have not been started yet and waits for the running ones
+	 */
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/**
+	 * Queues a task, it is run on one of the worker threads
+	 *
+	 * @param fnTask  Task to run
+	 */
+	void submit(std::function<void()> fnTask);
+
+	/**
+	 * @return number of worker threads
+	 */
+	std::size_t size() const;
+
+	/**
+	 * @return a sensible number of worker threads for background work, leaving one core to the render thread
+	 */
+	static std::size_t defaultThreadCount();
+
+	/**
+	 * Splits defaultThreadCount between several pools running at the same time, so that together they still leave one
+	 * core to the render thread. Lower pool indices receive the remainder.
+	 *
+	 * @param uiPool   Index of the pool, in [0, uiPools)
+	 * @param uiPools  Number of pools sharing the cores
+	 * @return number of worker threads of the pool, at least one
+	 */
+	static std::size_t defaultThreadCount(const std::size_t uiPool, const std::size_t uiPools);
+
+private:
+	/**
+	 * Main loop of the worker threads
+	 */
+	void work();
+};
+
+
+#endif // !THREAD_POOL_H
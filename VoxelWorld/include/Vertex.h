@@ -4,10 +4,27 @@
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
+#include <cstdint>
+
 struct Vertex {
     Vertex(glm::vec3 p, glm::vec2 t) : position(p), texturePosition(t){};
     glm::vec3 position = glm::vec3();
     glm::vec2 texturePosition = glm::vec2();
 };
 
+/*
+ * Compact vertex of a chunk mesh, packed into 32 bits:
+ *   bits  0- 4: x, bits 5-11: y, bits 12-16: z + 1 (corner position in voxels within the chunk)
+ *   bits 17-19: cube face (top, bottom, right, left, front, back)
+ *   bits 20-24: texture atlas tile
+ * mesh.vert unpacks the position and derives the texture coordinates from face and tile.
+ */
+struct PackedVertex {
+    PackedVertex(glm::ivec3 p, int face, int tile)
+        : data(static_cast<std::uint32_t>(p.x) | static_cast<std::uint32_t>(p.y) << 5 |
+               static_cast<std::uint32_t>(p.z + 1) << 12 | static_cast<std::uint32_t>(face) << 17 |
+               static_cast<std::uint32_t>(tile) << 20){};
+    std::uint32_t data = 0;
+};
+
 #endif // !VERTEX_H
@@ -0,0 +1,88 @@
+#ifndef CHUNK_MESHER_H
+#define CHUNK_MESHER_H
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Vertex.h"
+#include "voxel/MeshingContext.h"
+
+
+/**
+ * Turns the exposed voxel faces of a chunk into quads at full resolution.
+ *
+ * The meshers only read a MeshingContext and write packed vertices, they do not touch any GL state, so they can run on
+ * worker threads and in the headless benchmark.
+ */
+class ChunkMesher final
+{
+public:
+	/**
+	 * Strategy used to turn the exposed voxel faces of a chunk into quads
+	 */
+	enum class MeshingMode
+	{
+		/** One quad for every exposed voxel face */
+		eNaive,
+		/** Coplanar faces of the same block type are merged into maximal rectangles */
+		eGreedy,
+		/** Same quads as eNaive, but exposed faces are found with 64-bit column occupancy masks */
+		eBinary,
+	};
+
+	/**
+	 * One face of the unit cube
+	 */
+	struct CubeFace
+	{
+		/** Offset to the neighbouring voxel which must be air for the face to be visible */
+		glm::ivec3 xNormal;
+
+		/** Corners of the face as a counter-clockwise quad, in voxels. See RenderChunk for the triangulation. */
+		std::array<glm::ivec3, 4> arrCorners;
+	};
+
+	/**
+	 * Faces of a standard cube mesh, in the order top, bottom, right, left, front, back.
+	 * The index of a face is passed to mesh.vert, which derives the texture coordinates from it.
+	 */
+	static const std::array<CubeFace, 6> k_arrCubeFaces;
+
+	ChunkMesher() = delete;
+
+	/**
+	 * Meshes a chunk with the given strategy, appending four vertices per quad
+	 *
+	 * @param vecVertices  Receives the vertices of the quads
+	 * @param xContext     Chunk to mesh, with the apron taken from its neighbours
+	 * @param eMode        Strategy to use
+	 * @return the number of exposed faces, i.e. quads the naive mesher emits
+	 */
+	static std::uint64_t meshChunk(std::vector<PackedVertex>& vecVertices, const MeshingContext& xContext,
+	                               const MeshingMode eMode);
+
+	/**
+	 * Covers the visible faces of a slice greedily with rectangles and clears the mask.
+	 * Shared by the greedy mesher and the meshers of reduced levels of detail.
+	 *
+	 * @param vecVertices  Receives the vertices of the rectangles
+	 * @param vecMask      Block type of the face of every cell of the slice, or air, in the order u * iSizeV + v
+	 * @param xFace        Face the slice is made of
+	 * @param iFaceIndex   Index of xFace in k_arrCubeFaces
+	 * @param xVoxel       Position of the slice along the face normal, the other components are ignored
+	 * @param iU           Axis of the rows of the mask
+	 * @param iV           Axis of the columns of the mask
+	 * @param iSizeU       Number of rows of the mask
+	 * @param iSizeV       Number of columns of the mask
+	 * @param iScale       Size of a cell of the mask along each axis [voxels]
+	 */
+	static void coverMask(std::vector<PackedVertex>& vecVertices, std::vector<char>& vecMask, const CubeFace& xFace,
+	                      const int iFaceIndex, glm::ivec3 xVoxel, const int iU, const int iV, const int iSizeU,
+	                      const int iSizeV, const int iScale);
+};
+
+
+#endif // !CHUNK_MESHER_H
@@ -0,0 +1,154 @@
+#ifndef MESHING_CONTEXT_H
+#define MESHING_CONTEXT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "voxel/WorldGenerator.h"
+
+
+/**
+ * Copy of a chunk surrounded by a one voxel apron taken from its neighbours.
+ *
+ * The neighbouring chunks are copied once when the context is built, so the meshers can look at the neighbours of any
+ * voxel of the chunk without branching on chunk borders or accessing the world generator.
+ */
+class MeshingContext final
+{
+public:
+	/** Size of the padded volume along x */
+	static const int k_iSizeX = CHUNK_SIZE + 2;
+
+	/** Size of the padded volume along y */
+	static const int k_iSizeY = CHUNK_HEIGHT + 2;
+
+	/** Size of the padded volume along z */
+	static const int k_iSizeZ = CHUNK_SIZE + 2;
+
+	/** Distance between the indices of two voxels neighbouring along x */
+	static const int k_iStrideX = k_iSizeY * k_iSizeZ;
+
+	/** Distance between the indices of two voxels neighbouring along y */
+	static const int k_iStrideY = k_iSizeZ;
+
+	/** Distance between the indices of two voxels neighbouring along z */
+	static const int k_iStrideZ = 1;
+
+private:
+	/**
+	 * Voxels of the padded volume. The layer below the chunk is solid, as faces at the bottom of the world are never
+	 * visible, the layer above is air. The apron columns at the corners are not used and left as air.
+	 */
+	char m_arrVoxels[k_iSizeX * k_iSizeY * k_iSizeZ];
+
+	/**
+	 * Sections which cannot have visible faces: all air, or all solid and enclosed by solid sections
+	 */
+	bool m_arrSkippedSections[SECTION_COUNT];
+
+	/**
+	 * Per column of the chunk, the lowest layer which can have a visible face. Voxels below it are solid and so are
+	 * their neighbours.
+	 */
+	std::uint8_t m_arrColumnBegin[CHUNK_SIZE][CHUNK_SIZE];
+
+	/**
+	 * Per column of the chunk, one more than its highest solid layer
+	 */
+	std::uint8_t m_arrColumnEnd[CHUNK_SIZE][CHUNK_SIZE];
+
+	/**
+	 * Minimum of m_arrColumnBegin
+	 */
+	int m_iMeshedBegin;
+
+	/**
+	 * Maximum of m_arrColumnEnd
+	 */
+	int m_iMeshedEnd;
+
+public:
+	/**
+	 * Builds the padded volume for a chunk
+	 *
+	 * @param xChunk  Voxels of the chunk
+	 * @param xLeft   Neighbouring chunk towards -x
+	 * @param xRight  Neighbouring chunk towards +x
+	 * @param xBack   Neighbouring chunk towards -z
+	 * @param xFront  Neighbouring chunk towards +z
+	 */
+	MeshingContext(const Chunk& xChunk, const Chunk& xLeft, const Chunk& xRight, const Chunk& xBack, const Chunk& xFront);
+
+	/**
+	 * @return whether the meshers can skip the section, as none of its faces are visible
+	 */
+	bool isSectionSkipped(const int iSection) const
+	{
+		return m_arrSkippedSections[iSection];
+	}
+
+	/**
+	 * @return number of sections the meshers can skip
+	 */
+	int getSkippedSectionCount() const;
+
+	/**
+	 * @return lowest layer of the column which can have a visible face
+	 */
+	int getColumnBegin(const int iX, const int iZ) const
+	{
+		return m_arrColumnBegin[iX][iZ];
+	}
+
+	/**
+	 * @return one more than the highest layer of the column which can have a visible face
+	 */
+	int getColumnEnd(const int iX, const int iZ) const
+	{
+		return m_arrColumnEnd[iX][iZ];
+	}
+
+	/**
+	 * @return lowest layer of the chunk which can have a visible face
+	 */
+	int getMeshedBegin() const
+	{
+		return m_iMeshedBegin;
+	}
+
+	/**
+	 * @return one more than the highest layer of the chunk which can have a visible face, getMeshedBegin if there is
+	 *         none
+	 */
+	int getMeshedEnd() const
+	{
+		return m_iMeshedEnd;
+	}
+
+	/**
+	 * @return index into the padded volume of the voxel at the given chunk coordinates, each in [-1, size]
+	 */
+	static int index(const int iX, const int iY, const int iZ)
+	{
+		return (iX + 1) * k_iStrideX + (iY + 1) * k_iStrideY + (iZ + 1) * k_iStrideZ;
+	}
+
+	/**
+	 * @return voxel at the given index of the padded volume
+	 */
+	char operator[](const int iIndex) const
+	{
+		return m_arrVoxels[static_cast<std::size_t>(iIndex)];
+	}
+
+	/**
+	 * @return voxel at the given chunk coordinates, each in [-1, size]
+	 */
+	char operator()(const int iX, const int iY, const int iZ) const
+	{
+		return m_arrVoxels[static_cast<std::size_t>(index(iX, iY, iZ))];
+	}
+};
+
+
+#endif // !MESHING_CONTEXT_H
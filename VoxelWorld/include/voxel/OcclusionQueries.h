@@ -0,0 +1,192 @@
+#ifndef OCCLUSION_QUERIES_H
+#define OCCLUSION_QUERIES_H
+
+#include <GL/glew.h>
+
+#include <glm/gtx/hash.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "RingBuffer.h"
+#include "ShaderProgram.h"
+
+
+/**
+ * Hardware occlusion queries for the bounding boxes of chunks, one GL_ANY_SAMPLES_PASSED_CONSERVATIVE query per chunk.
+ *
+ * The boxes are drawn after the chunks of a frame, against their depth buffer and without writing color or depth.
+ * Results are only read once the GPU reports them available, so the CPU never waits for a query; until then a chunk
+ * keeps the result of its previous query, and chunks without a result count as visible. A chunk hidden in one frame is
+ * therefore drawn again one or two frames after it becomes visible, as its box is queried in every frame it is in the
+ * frustum. Results are only trusted for chunks queued in the previous frame: a chunk returning to the frustum counts
+ * as visible until a query issued after its return has a result.
+ *
+ * The boxes are written to a persistently mapped voxel::RingBuffer and drawn as 14 vertex triangle strips generated
+ * by the vertex shader, the base instance of a draw selects its box.
+ */
+class OcclusionQueries final
+{
+public:
+	/**
+	 * Query counts of the last frame
+	 */
+	struct Statistics
+	{
+		/** Number of queries issued */
+		std::size_t uiIssued = 0;
+
+		/** Number of queries whose result became available */
+		std::size_t uiResults = 0;
+	};
+
+private:
+	/**
+	 * Query of one chunk
+	 */
+	struct Query
+	{
+		/** Handle to the OpenGL query object */
+		GLuint uiQuery;
+
+		/** Frame in which the chunk was queued last */
+		std::uint64_t uiLastFrame;
+
+		/** Whether the query has been issued and its result not read yet */
+		bool bPending;
+
+		/** Whether the latest available result found no visible sample */
+		bool bOccluded;
+
+		/** Whether the pending query was issued before the chunk left the frustum, its result is dropped */
+		bool bStale;
+	};
+
+	/**
+	 * Box queued for the current frame, laid out as in the shader storage buffer
+	 */
+	struct Box
+	{
+		glm::vec4 xMin;
+		glm::vec4 xMax;
+	};
+
+	/**
+	 * Frames a chunk may go without being queued before its query object is recycled
+	 */
+	static const std::uint64_t k_uiMaxIdleFrames = 120;
+
+	/**
+	 * Size [bytes] of the stream buffer, room for the boxes of a few frames
+	 */
+	static const voxel::RingBuffer::size_type k_xStreamBufferSize = 1024 * 1024;
+
+	/**
+	 * Shader transforming the boxes
+	 */
+	ShaderProgram m_xShaderProgram;
+
+	/**
+	 * Handle to an empty vertex array object, the vertices are generated by the shader
+	 */
+	GLuint m_uiVertexArrayObject;
+
+	/**
+	 * Stream buffer for the boxes
+	 */
+	voxel::RingBuffer m_xStreamBuffer;
+
+	/**
+	 * Required alignment [bytes] of the offset of a shader storage buffer range
+	 */
+	voxel::RingBuffer::size_type m_xStorageAlignment;
+
+	/**
+	 * Queries of the chunks queued within the last k_uiMaxIdleFrames frames, by chunk position
+	 */
+	std::unordered_map<glm::ivec3, Query> m_mapQueries;
+
+	/**
+	 * Query objects of recycled queries, reused before new ones are generated
+	 */
+	std::vector<GLuint> m_vecFreeQueries;
+
+	/**
+	 * Chunks queued for the current frame, by their position
+	 */
+	std::vector<glm::ivec3> m_vecQueued;
+
+	/**
+	 * Boxes of the chunks queued for the current frame, in the order of m_vecQueued
+	 */
+	std::vector<Box> m_vecBoxes;
+
+	/**
+	 * Number of the current frame
+	 */
+	std::uint64_t m_uiFrame;
+
+	/**
+	 * Query counts of the current frame
+	 */
+	Statistics m_xStatistics;
+
+	/**
+	 * Query counts of the last frame
+	 */
+	Statistics m_xLastStatistics;
+
+public:
+	/**
+	 * Loads the shader and creates the buffers
+	 */
+	OcclusionQueries();
+
+	/**
+	 * Destructor, frees the query objects
+	 */
+	~OcclusionQueries();
+
+	OcclusionQueries(const OcclusionQueries&) = delete;
+	OcclusionQueries& operator=(const OcclusionQueries&) = delete;
+
+	/**
+	 * Reads the result of the query of a chunk if the GPU has it ready, without waiting for it. Must be called before
+	 * the chunk is queued in the current frame.
+	 *
+	 * @param xPosition  Position of the chunk
+	 * @return whether the latest available result found the chunk hidden, false if there is none or the chunk was not
+	 *         queued in the previous frame
+	 */
+	bool isOccluded(const glm::ivec3& xPosition);
+
+	/**
+	 * Queues the box of a chunk to be queried by the next call of issueQueued. A chunk whose previous query has no
+	 * result yet is not queried again. The result of a chunk which was not queued in the previous frame is dropped.
+	 *
+	 * @param xPosition  Position of the chunk
+	 * @param xMin       Minimum corner of the box in world coordinates
+	 * @param xMax       Maximum corner of the box in world coordinates
+	 */
+	void queue(const glm::ivec3& xPosition, const glm::vec3& xMin, const glm::vec3& xMax);
+
+	/**
+	 * Draws the queued boxes with one query each, clears the queue and recycles the queries of chunks which have not
+	 * been queued for a while. Must be called after the occluding geometry has been drawn.
+	 *
+	 * @param xViewProjection  Matrix transforming world coordinates into clip space
+	 */
+	void issueQueued(const glm::mat4& xViewProjection);
+
+	/**
+	 * @return query counts of the last frame
+	 */
+	const Statistics& getStatistics() const;
+};
+
+
+#endif // !OCCLUSION_QUERIES_H
@@ -0,0 +1,242 @@
+#ifndef REGION_STORE_H
+#define REGION_STORE_H
+
+#include <glm/gtx/hash.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "voxel/WorldGenerator.h"
+
+
+/**
+ * Persists generated chunks in region files, each holding the chunks of a square of k_iRegionSize x k_iRegionSize
+ * chunk positions, so a world does not have to be generated again on every launch or after its chunks were evicted.
+ *
+ * A region file starts with a header: the magic "VXRG", the format version and a table with the offset and size
+ * [bytes] of every chunk, zero for chunks not stored yet. The chunks follow, every chunk as runs of equal voxels along
+ * its columns, two bytes per run: the length and the voxel. All integers are little endian. Chunks are only ever
+ * appended, a chunk stored again leaves its previous data unused.
+ *
+ * Chunks are read from read-only shared memory mappings of the region files, which are mapped again when the table
+ * points beyond the mapped size. Chunks are written by a background thread: save only queues the encoded chunk, the
+ * writer appends it to its region file and updates the table afterwards, so readers never find an entry whose data
+ * is incomplete. The chunks form a single layer, the position along y is ignored.
+ */
+class RegionStore final
+{
+public:
+	/** Number of chunk positions along x and z covered by a region file */
+	static const int k_iRegionSize = 32;
+
+	/**
+	 * Counts of the loaded and saved chunks
+	 */
+	struct Statistics
+	{
+		/** Number of chunks read from region files */
+		std::uint64_t uiLoadedChunks = 0;
+
+		/** CPU time [seconds] spent reading and decoding the loaded chunks */
+		double dLoadTime = 0.0;
+
+		/** Number of chunks written to region files */
+		std::uint64_t uiSavedChunks = 0;
+
+		/** Bytes of chunk data written to region files */
+		std::uint64_t uiSavedBytes = 0;
+
+		/** Number of chunks waiting for the writer */
+		std::size_t uiQueuedWrites = 0;
+
+		/** Number of writes which failed, e.g. as the directory is not writable */
+		std::uint64_t uiFailedWrites = 0;
+	};
+
+private:
+	/**
+	 * Read-only memory mapping of a whole region file, defined per platform
+	 */
+	class MappedFile;
+
+	/**
+	 * Encoded chunk waiting for the writer
+	 */
+	struct Write
+	{
+		/** Position of the chunk */
+		glm::ivec3 xPosition;
+
+		/** Encoded voxels of the chunk */
+		std::vector<std::uint8_t> vecData;
+	};
+
+	/**
+	 * Directory holding the region files
+	 */
+	const std::string k_strDirectory;
+
+	/**
+	 * Guards m_mapMappings
+	 */
+	std::mutex m_xMappingMutex;
+
+	/**
+	 * Mappings of the region files read so far, by region position. A mapping is replaced when the file grew, readers
+	 * keep the previous one alive while they decode from it.
+	 */
+	std::unordered_map<glm::ivec2, std::shared_ptr<const MappedFile>> m_mapMappings;
+
+	/**
+	 * Region files opened by the writer, only used on the writer thread
+	 */
+	std::unordered_map<glm::ivec2, std::unique_ptr<std::fstream>> m_mapFiles;
+
+	/**
+	 * Guards the write queue, the stop flag and the statistics
+	 */
+	mutable std::mutex m_xWriteMutex;
+
+	/**
+	 * Signalled when a write was queued or the store is being destroyed
+	 */
+	std::condition_variable m_xWriteCondition;
+
+	/**
+	 * Chunks waiting for the writer, in the order they were saved
+	 */
+	std::deque<Write> m_deqWrites;
+
+	/**
+	 * Set when the store is being destroyed, the writer finishes the queued writes and returns
+	 */
+	bool m_bStop;
+
+	/**
+	 * Counts of the loaded and saved chunks
+	 */
+	Statistics m_xStatistics;
+
+	/**
+	 * Thread appending the queued chunks to the region files. Declared last so it is started after the members it uses.
+	 */
+	std::thread m_xWriter;
+
+public:
+	/**
+	 * Starts the writer, creating the directory when the first chunk is written
+	 *
+	 * @param strDirectory  Directory holding the region files
+	 */
+	explicit RegionStore(const std::string& strDirectory);
+
+	/**
+	 * Destructor
+	 * Writes the queued chunks and stops the writer
+	 */
+	~RegionStore();
+
+	RegionStore(const RegionStore&) = delete;
+	RegionStore& operator=(const RegionStore&) = delete;
+
+	/**
+	 * Reads a chunk from its region file
+	 *
+	 * @param xPosition  Position of the chunk
+	 * @return the chunk, an empty pointer if it has not been stored or its data is damaged
+	 */
+	std::shared_ptr<Chunk> load(const glm::ivec3& xPosition);
+
+	/**
+	 * Encodes a chunk and queues it to be written to its region file on the writer thread
+	 *
+	 * @param xPosition  Position of the chunk
+	 * @param xChunk     Chunk to store
+	 */
+	void save(const glm::ivec3& xPosition, const Chunk& xChunk);
+
+	/**
+	 * @return counts of the loaded and saved chunks
+	 */
+	Statistics getStatistics() const;
+
+	/**
+	 * Encodes the voxels of a chunk as runs along its columns
+	 *
+	 * @param xChunk  Chunk to encode
+	 * @return runs of the chunk, two bytes per run
+	 */
+	static std::vector<std::uint8_t> encode(const Chunk& xChunk);
+
+	/**
+	 * Decodes a chunk encoded by encode
+	 *
+	 * @param pData   Runs of the chunk
+	 * @param uiSize  Number of bytes of the runs
+	 * @return the chunk, an empty pointer if the runs do not cover the chunk exactly
+	 */
+	static std::shared_ptr<Chunk> decode(const std::uint8_t* pData, const std::size_t uiSize);
+
+private:
+	/**
+	 * @param xPosition  Position of a chunk
+	 * @return position of the region holding the chunk
+	 */
+	static glm::ivec2 regionOf(const glm::ivec3& xPosition);
+
+	/**
+	 * @param xPosition  Position of a chunk
+	 * @return index of the chunk in the table of its region file
+	 */
+	static std::size_t tableIndex(const glm::ivec3& xPosition);
+
+	/**
+	 * @param xRegion  Position of a region
+	 * @return path of the region file
+	 */
+	std::string regionPath(const glm::ivec2& xRegion) const;
+
+	/**
+	 * Returns a mapping of a region file which covers the given number of bytes, mapping the file again if the current
+	 * mapping is shorter
+	 *
+	 * @param xRegion  Position of the region
+	 * @param uiBytes  Number of bytes from the start of the file the mapping must cover, at least the header
+	 * @return the mapping, an empty pointer if the file does not exist or is shorter
+	 */
+	std::shared_ptr<const MappedFile> mapRegion(const glm::ivec2& xRegion, const std::size_t uiBytes);
+
+	/**
+	 * Main loop of the writer thread
+	 */
+	void writeQueued();
+
+	/**
+	 * Appends a chunk to its region file and points the table to it
+	 *
+	 * @param xWrite  Chunk to write
+	 * @return whether the chunk was written
+	 */
+	bool writeChunk(const Write& xWrite);
+
+	/**
+	 * Opens a region file for writing, creating it with an empty table or recreating it if its header is invalid
+	 *
+	 * @param xRegion  Position of the region
+	 * @return the open file, nullptr if it cannot be opened
+	 */
+	std::fstream* openRegion(const glm::ivec2& xRegion);
+};
+
+
+#endif // !REGION_STORE_H
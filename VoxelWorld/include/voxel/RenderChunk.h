@@ -6,29 +6,81 @@
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "Vertex.h"
+#include "voxel/VertexArena.h"
+#include "voxel/VisibilityGraph.h"
+#include "voxel/WorldGenerator.h"
 
 
 class RenderChunk final
 {
+public:
+	/**
+	 * Upper bound for the number of quads of a chunk mesh. Every pair of adjacent voxels, including the pairs across
+	 * the chunk borders, contributes at most one face.
+	 */
+	static const std::uint32_t k_uiMaxQuads = 2 * (CHUNK_SIZE + 1) * CHUNK_HEIGHT * CHUNK_SIZE + CHUNK_SIZE * (CHUNK_HEIGHT + 1) * CHUNK_SIZE;
+
+	/** Number of occluder cells along x and z, each covering a square of columns */
+	static const int k_iOccluderCells = 2;
+
+	/**
+	 * Heights of the occluders of a chunk, per cell in the order x * k_iOccluderCells + z. The voxels of all columns of
+	 * a cell are solid up to this height.
+	 */
+	using OccluderHeights = std::array<std::uint8_t, k_iOccluderCells * k_iOccluderCells>;
+
+	/**
+	 * Levels of detail of the neighbours of a chunk, in the order of the side faces of
+	 * ChunkMesher::k_arrCubeFaces: right, left, front, back
+	 */
+	using NeighbourLods = std::array<int, 4>;
+
 private:
 	/**
-	 * Handle to the vertex array object
+	 * Arena holding the vertices
+	 */
+	VertexArena& m_xArena;
+
+	/**
+	 * Vertices of this chunk within the arena, four per quad
+	 */
+	VertexArena::Allocation m_xAllocation;
+
+	/**
+	 * Level of detail of the mesh, level l merges 2^l voxels along each axis into one cell
+	 */
+	const int k_iLod;
+
+	/**
+	 * Levels of detail of the neighbours the mesh was generated for, which decide about its skirts
+	 */
+	const NeighbourLods k_arrNeighbourLods;
+
+	/**
+	 * Lowest layer of the chunk which has visible faces
 	 */
-	std::uint32_t m_uiVertexArrayObject;
+	const int k_iMinHeight;
 
 	/**
-	 * Handle to the buffer object
+	 * One more than the highest layer of the chunk which has visible faces
 	 */
-	std::uint32_t m_uiVertexBufferObject;
+	const int k_iMaxHeight;
 
 	/**
-	 * Amount of vertices this render object consists of
+	 * Heights up to which the cells of the chunk are solid, used as occluders for software occlusion culling
 	 */
-	const std::uint32_t k_uiNumVertices;
+	const OccluderHeights k_arrOccluderHeights;
+
+	/**
+	 * Faces connected by air within each section of the chunk, used for cave culling
+	 */
+	const VisibilityGraph::ChunkConnectivity k_arrConnectivity;
 
 public:
 	/**
@@ -38,29 +90,74 @@ public:
 
 	/**
 	 * Destructor
-	 * Frees up allocated GPU memory
+	 * Releases the vertices in the arena
 	 */
 	virtual ~RenderChunk();
 
 	/**
 	 * Move constructor
-	 * Invalidates GPU object handles to ensure memory remains valid for new object
+	 * Takes over the vertices, the other object no longer releases them
 	 */
 	RenderChunk(RenderChunk&& xOther);
 
 	/**
 	* Constructs a new render chunk given the vertices
 	*
-	* @param vecVertices  Vector of vertices which build up this render chunk
+	* @param xArena       Arena holding the vertices
+	* @param xAllocation  Vertices of this chunk within the arena, released when the render chunk is destroyed
+	* @param iLod         Level of detail of the mesh, 0 for full resolution
+	* @param arrNeighbourLods  Levels of detail of the neighbours the mesh was generated for
+	* @param iMinHeight   Lowest layer of the chunk which has visible faces
+	* @param iMaxHeight   One more than the highest layer of the chunk which has visible faces
+	* @param arrOccluderHeights  Heights up to which the cells of the chunk are solid
+	* @param arrConnectivity     Faces connected by air within each section of the chunk
 	*/
-	RenderChunk(const std::vector<Vertex>& vecVertices);
+	RenderChunk(VertexArena& xArena, const VertexArena::Allocation& xAllocation, const int iLod, const NeighbourLods& arrNeighbourLods, const int iMinHeight, const int iMaxHeight, const OccluderHeights& arrOccluderHeights,
+		const VisibilityGraph::ChunkConnectivity& arrConnectivity);
+
+	/**
+	 * @return GPU memory [bytes] used by the vertices of this chunk
+	 */
+	std::size_t getByteSize() const;
+
+	/**
+	 * @return level of detail of the mesh, 0 for full resolution
+	 */
+	int getLod() const;
+
+	/**
+	 * @return levels of detail of the neighbours the mesh was generated for, which decide about its skirts
+	 */
+	const NeighbourLods& getNeighbourLods() const;
+
+	/**
+	 * @return lowest layer of the chunk which has visible faces, the lower bound of its bounding box
+	 */
+	int getMinHeight() const;
+
+	/**
+	 * @return one more than the highest layer of the chunk which has visible faces, the upper bound of its bounding box
+	 */
+	int getMaxHeight() const;
+
+	/**
+	 * @param iCellX  Index of the occluder cell along x
+	 * @param iCellZ  Index of the occluder cell along z
+	 * @return height up to which all voxels of the cell are solid, zero if the cell has a hole down to the bottom
+	 */
+	int getOccluderHeight(const int iCellX, const int iCellZ) const;
+
+	/**
+	 * @return faces connected by air within each section of the chunk
+	 */
+	const VisibilityGraph::ChunkConnectivity& getConnectivity() const;
 
 	/**
-	 * Renders this chunk
+	 * Queues this chunk to be drawn with the next VertexArena::drawQueued
 	 *
-	 * @param bWireframe  Whether or not the chunk should be rendered in wireframe mode
+	 * @param xPosition  Position of the chunk
 	 */
-    void render(const bool bWireframe) const;
+	void queueDraw(const glm::vec3& xPosition) const;
 };
 
 
@@ -7,41 +7,280 @@
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <unordered_set>
 #include <vector>
 #include <list>
 
 #include "Mesh.h"
 #include "Vertex.h"
 #include "LimitedUnorderedMap.h"
+#include "ThreadPool.h"
+#include "voxel/ChunkMesher.h"
 #include "voxel/RenderChunk.h"
+#include "voxel/VertexArena.h"
 #include "voxel/WorldGenerator.h"
 
 
 /*
- * Generate mesh and texture coordinate from a Chunk
+ * Generate mesh and texture coordinate from a Chunk.
+ * Meshing runs on a pool of worker threads, only the upload of the finished meshes happens on the GL thread.
+ *
+ * Distant chunks can be meshed at a lower level of detail: level l downsamples the chunk into cells of 2^l voxels
+ * along each axis by majority vote and meshes the cells greedily. Neighbouring chunks of different levels do not match
+ * at their common border, so a mesh gets skirts towards the neighbours drawn at another level: walls facing out of the
+ * chunk below the top of its border columns which hide the cracks. A skirt is as deep as k_iSkirtCells cells of the
+ * coarser of both levels. Borders between neighbours of the same level have none.
  */
 class RenderChunkGenerator final
 {
+public:
+	/** Number of levels of detail, the coarsest level merges 8 voxels along each axis */
+	static const int k_iLodCount = 4;
+
+	/** Number of cells of the coarser level below the top of a border column covered by the skirts */
+	static const int k_iSkirtCells = 2;
+
+	using NeighbourLods = RenderChunk::NeighbourLods;
+
+	using MeshingMode = ChunkMesher::MeshingMode;
+
+	using CubeFace = ChunkMesher::CubeFace;
+
+	/**
+	 * Vertex counts of the generated meshes, compared to what the naive mesher would have produced
+	 */
+	struct Statistics
+	{
+		/** Vertices the naive mesher would have emitted for the most recently meshed chunk */
+		std::uint64_t uiLastNaiveVertices = 0;
+
+		/** Vertices actually emitted for the most recently meshed chunk */
+		std::uint64_t uiLastVertices = 0;
+
+		/** Vertices the naive mesher would have emitted for all chunks meshed so far */
+		std::uint64_t uiTotalNaiveVertices = 0;
+
+		/** Vertices actually emitted for all chunks meshed so far */
+		std::uint64_t uiTotalVertices = 0;
+
+		/** Number of chunks meshed so far */
+		std::uint64_t uiMeshedChunks = 0;
+
+		/** Sections of the chunks meshed so far which were skipped, as they were empty or buried */
+		std::uint64_t uiSkippedSections = 0;
+
+		/** Number of chunks meshed at a reduced level of detail so far, not included in the other counts */
+		std::uint64_t uiDownsampledChunks = 0;
+
+		/** Number of times a mesh did not fit into the vertex arena, it is kept and uploaded in a later frame */
+		std::uint64_t uiFailedUploads = 0;
+
+		/** CPU time [seconds] spent meshing the most recently meshed chunk */
+		double dLastMeshingTime = 0.0;
+
+		/** CPU time [seconds] spent meshing all chunks so far */
+		double dTotalMeshingTime = 0.0;
+	};
+
 private:
+	/**
+	 * Mesh produced by a worker thread, waiting to be uploaded on the GL thread
+	 */
+	struct MeshingResult
+	{
+		/** Position of the meshed chunk */
+		glm::ivec3 xPosition;
+
+		/** Value of m_uiGeneration when the chunk was queued */
+		std::uint64_t uiGeneration;
+
+		/** Level of detail of the mesh */
+		int iLod;
+
+		/** Levels of detail of the neighbours, which decide about the skirts */
+		NeighbourLods arrNeighbourLods;
+
+		/** Number of vertices of the skirts, at the end of vecVertices */
+		std::uint64_t uiSkirtVertices;
+
+		/** Vertices of the mesh */
+		std::vector<PackedVertex> vecVertices;
+
+		/** Number of exposed faces, i.e. quads the naive mesher would have emitted */
+		std::uint64_t uiExposedFaces;
+
+		/** Number of sections skipped by the mesher */
+		std::uint64_t uiSkippedSections;
+
+		/** Lowest layer of the chunk which has visible faces */
+		int iMinHeight;
+
+		/** One more than the highest layer of the chunk which has visible faces */
+		int iMaxHeight;
+
+		/** Heights up to which the occluder cells of the chunk are solid */
+		RenderChunk::OccluderHeights arrOccluderHeights;
+
+		/** Faces connected by air within each section of the chunk */
+		VisibilityGraph::ChunkConnectivity arrConnectivity;
+
+		/** CPU time [seconds] spent meshing */
+		double dMeshingTime;
+	};
 
 	/**
-	 * Vertices for a standard cube mesh in NDC.
+	 * Vertices of all render chunks. Declared before the cache, as the render chunks release their vertices in it.
 	 */
-	static const std::vector<Vertex> k_vecCubeMesh;
+	VertexArena m_xArena;
 
 	/**
-	 * Cache for the rendered chunks.
+	 * Cache for the rendered chunks, limited by the GPU memory of their vertices
 	 */
 	LimitedUnorderedMap<glm::ivec3, RenderChunk> chunkCache;
 
+	/**
+	 * Strategy used for newly meshed chunks
+	 */
+	MeshingMode m_eMeshingMode;
+
+	/**
+	 * Vertex counts of the meshed chunks
+	 */
+	Statistics m_xStatistics;
+
+	/**
+	 * Positions of the chunks queued on or being meshed by the workers
+	 */
+	std::unordered_set<glm::ivec3> m_setPending;
+
+	/**
+	 * Incremented whenever the cached meshes become invalid, results queued in an older generation are dropped
+	 */
+	std::uint64_t m_uiGeneration;
+
+	/**
+	 * Guards m_vecResults, which is filled by the workers
+	 */
+	std::mutex m_xResultMutex;
+
+	/**
+	 * Meshes finished by the workers, waiting to be picked up by uploadMeshedChunks
+	 */
+	std::vector<MeshingResult> m_vecResults;
+
+	/**
+	 * Meshes picked up but not uploaded yet, as the upload budget of a frame was exhausted. Only used on the GL thread.
+	 */
+	std::vector<MeshingResult> m_vecReady;
+
+	/**
+	 * Workers meshing the chunks. Declared last so the workers are stopped before the members they use are destroyed.
+	 */
+	ThreadPool m_xThreadPool;
+
 public:
 	/**
 	 * Constructor
+	 *
+	 * @param cacheBytes  GPU memory [bytes] the vertices of the cached render chunks may use. The vertex arena is a
+	 *                    quarter larger, to leave room for fragmentation.
+	 */
+    RenderChunkGenerator(std::size_t cacheBytes);
+
+	/**
+	 * Returns the render chunk for the chunk at the given position.
+	 * If the chunk has not been meshed yet, meshing is queued on the worker threads and an empty pointer is returned;
+	 * the render chunk is available once a later call of uploadMeshedChunks picked up the mesh. If the chunk or one of
+	 * its neighbours has not been generated yet, they are requested from the world generator instead.
+	 * Only one level of detail is cached per chunk. If the cached mesh has another level, or its skirts do not match
+	 * the levels of the neighbours, the chunk is meshed again and the cached mesh is returned until the new one
+	 * replaces it.
+	 *
+	 * @param position        Position of the chunk
+	 * @param lod             Level of detail of the mesh, in [0, k_iLodCount)
+	 * @param neighbourLods   Levels of detail the neighbours are drawn at, borders to other levels get skirts
+	 * @param worldGenerator  Generator providing the chunk and its neighbours
+	 */
+    const std::shared_ptr<RenderChunk> fromChunk(const glm::ivec3 position, const int lod, const NeighbourLods& neighbourLods,
+                                                 WorldGenerator& worldGenerator);
+
+	/**
+	 * Returns the render chunk for the chunk at the given position if it is cached, without queueing anything
+	 *
+	 * @param position  Position of the chunk
+	 */
+	const std::shared_ptr<RenderChunk> findRenderChunk(const glm::ivec3 position) const;
+
+	/**
+	 * Creates the render chunks for the meshes the workers finished, the most important first, until the uploaded
+	 * vertices exceed the budget. The remaining meshes are kept for the next call, meshes of negative importance are
+	 * dropped and meshed again when they are requested again.
+	 * Must be called on the thread owning the GL context.
+	 *
+	 * @param byteBudget  Vertex bytes to upload, at least one mesh is uploaded if any is ready
+	 * @param importance  Importance of the chunk at a position, e.g. its expected size on screen
+	 * @return number of vertex bytes uploaded
+	 */
+	std::size_t uploadMeshedChunks(const std::size_t byteBudget, const std::function<float(const glm::ivec3&)>& importance);
+
+	/**
+	 * @return number of meshes waiting for upload
+	 */
+	std::size_t getReadyCount() const;
+
+	/**
+	 * @return number of chunks queued on or being meshed by the workers
 	 */
-    RenderChunkGenerator(std::size_t cacheSize);
+	std::size_t getPendingCount() const;
 
-    const std::shared_ptr<RenderChunk> fromChunk(const glm::ivec3 position, const Chunk& chunk, WorldGenerator& worldGenerator);
+	/**
+	 * Selects the meshing strategy. Changing it drops all cached render chunks so they get meshed again.
+	 *
+	 * @param eMeshingMode  Strategy to use for meshing chunks
+	 */
+	void setMeshingMode(const MeshingMode eMeshingMode);
+
+	/**
+	 * @return the strategy used for meshing chunks
+	 */
+	MeshingMode getMeshingMode() const;
+
+	/**
+	 * @return vertex counts of the meshed chunks
+	 */
+	const Statistics& getStatistics() const;
+
+	/**
+	 * @return hits, misses and evictions of the render chunk cache
+	 */
+	const LimitedUnorderedMap<glm::ivec3, RenderChunk>::Statistics& getCacheStatistics() const;
+
+	/**
+	 * @return number of cached render chunks
+	 */
+	std::size_t getCachedChunkCount() const;
+
+	/**
+	 * @return GPU memory [bytes] used by the vertices of the cached render chunks
+	 */
+	std::size_t getCachedBytes() const;
+
+	/**
+	 * Draws all render chunks queued since the last call with one multi draw indirect call per vertex page
+	 *
+	 * @param wireframe  Whether or not the chunks should be rendered in wireframe mode
+	 */
+	void drawQueued(const bool wireframe);
+
+	/**
+	 * @return arena holding the vertices of the render chunks
+	 */
+	const VertexArena& getArena() const;
 };
 
 
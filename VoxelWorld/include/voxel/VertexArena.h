@@ -0,0 +1,211 @@
+#ifndef VERTEX_ARENA_H
+#define VERTEX_ARENA_H
+
+#include <GL/glew.h>
+
+#include <glm/vec4.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "BufferAllocator.h"
+#include "RingBuffer.h"
+#include "Vertex.h"
+
+
+/**
+ * Vertex buffer pages holding the meshes of all render chunks, drawn with one indirect multi draw call per page and
+ * frame. The pages are managed by a voxel::BufferAllocator, which grows them on demand and compacts them a little
+ * every frame.
+ *
+ * Meshes are made of quads of four consecutive vertices, triangulated by a shared index buffer. Every queued draw
+ * references its mesh by the base vertex and its position by the base instance, which indexes the chunk offsets in a
+ * shader storage buffer range bound to binding point 0.
+ *
+ * Mesh uploads, draw commands and chunk offsets are written to a persistently mapped voxel::RingBuffer, fenced once
+ * per frame. Meshes are copied from there into their page on the GPU.
+ */
+class VertexArena final
+{
+public:
+	/**
+	 * Range of vertices owned by one mesh
+	 */
+	struct Allocation
+	{
+		/** Handle of the block in the allocator, valid if there are vertices */
+		voxel::BufferAllocator::handle_type uiHandle;
+
+		/** Number of vertices, four per quad */
+		std::uint32_t uiVertexCount;
+	};
+
+private:
+	/**
+	 * Layout of a command in the indirect buffer, as defined by glMultiDrawElementsIndirect
+	 */
+	struct DrawElementsIndirectCommand
+	{
+		std::uint32_t uiCount;
+		std::uint32_t uiInstanceCount;
+		std::uint32_t uiFirstIndex;
+		std::int32_t iBaseVertex;
+		std::uint32_t uiBaseInstance;
+	};
+
+	/**
+	 * Size [bytes] of a vertex buffer page
+	 */
+	static const voxel::BufferAllocator::size_type k_xPageSize = 16 * 1024 * 1024;
+
+	/**
+	 * Upper bound for the bytes moved by the compaction of the vertex buffer pages per frame
+	 */
+	static const voxel::BufferAllocator::size_type k_xCompactionBytesPerFrame = 1024 * 1024;
+
+	/**
+	 * Size [bytes] of the stream buffer, room for the uploads and draw commands of a few frames
+	 */
+	static const voxel::RingBuffer::size_type k_xStreamBufferSize = 16 * 1024 * 1024;
+
+	/**
+	 * Handle to the vertex array object
+	 */
+	GLuint m_uiVertexArrayObject;
+
+	/**
+	 * Allocator of the vertex buffer pages holding all meshes
+	 */
+	voxel::BufferAllocator m_xAllocator;
+
+	/**
+	 * Handle to the index buffer triangulating the largest possible mesh
+	 */
+	GLuint m_uiIndexBufferObject;
+
+	/**
+	 * Stream buffer for the mesh uploads, the draw commands and the chunk offsets
+	 */
+	voxel::RingBuffer m_xStreamBuffer;
+
+	/**
+	 * Required alignment [bytes] of the offset of a shader storage buffer range
+	 */
+	voxel::RingBuffer::size_type m_xStorageAlignment;
+
+	/**
+	 * Draw commands queued for the current frame, per vertex buffer page
+	 */
+	std::vector<std::vector<DrawElementsIndirectCommand>> m_vecPageCommands;
+
+	/**
+	 * Chunk offsets of the queued draw commands, indexed by their base instance
+	 */
+	std::vector<glm::vec4> m_vecOffsets;
+
+	/**
+	 * Draw commands of all pages, in the order of the pages
+	 */
+	std::vector<DrawElementsIndirectCommand> m_vecCommands;
+
+	/**
+	 * Number of meshes drawn by the last call of drawQueued
+	 */
+	std::size_t m_uiLastDrawnMeshes;
+
+	/**
+	 * Number of triangles drawn by the last call of drawQueued
+	 */
+	std::size_t m_uiLastDrawnTriangles;
+
+	/**
+	 * Number of draw calls issued by the last call of drawQueued
+	 */
+	std::size_t m_uiLastDrawCalls;
+
+	/**
+	 * Number of GL state changes made by the last call of drawQueued, i.e. buffer, vertex array and polygon mode binds
+	 */
+	std::size_t m_uiLastStateChanges;
+
+public:
+	/**
+	 * Creates the buffers and the vertex array
+	 *
+	 * @param uiCapacity  Number of vertices the arena can hold, rounded up to whole pages
+	 * @param uiMaxQuads  Upper bound for the number of quads of a single mesh
+	 */
+	VertexArena(const std::uint32_t uiCapacity, const std::uint32_t uiMaxQuads);
+
+	/**
+	 * Destructor, frees the GPU memory
+	 */
+	~VertexArena();
+
+	VertexArena(const VertexArena&) = delete;
+	VertexArena& operator=(const VertexArena&) = delete;
+
+	/**
+	 * Uploads a mesh into the first unused range large enough to hold it
+	 *
+	 * @param vecVertices  Vertices of the mesh, four per quad
+	 * @param xAllocation  Receives the range of the mesh
+	 * @return false if all pages are full or too fragmented, the arena is not changed then
+	 */
+	bool allocate(const std::vector<PackedVertex>& vecVertices, Allocation& xAllocation);
+
+	/**
+	 * Releases the range of a mesh
+	 *
+	 * @param xAllocation  Range returned by allocate
+	 */
+	void free(const Allocation& xAllocation);
+
+	/**
+	 * Queues a mesh to be drawn by the next call of drawQueued
+	 *
+	 * @param xAllocation  Range of the mesh
+	 * @param xOffset      Translation of the mesh
+	 */
+	void queueDraw(const Allocation& xAllocation, const glm::vec4& xOffset);
+
+	/**
+	 * Draws all queued meshes with one call per page, clears the queue and compacts the pages
+	 *
+	 * @param bWireframe  Whether or not the meshes should be rendered in wireframe mode
+	 */
+	void drawQueued(const bool bWireframe);
+
+	/**
+	 * @return memory usage and fragmentation of the vertex buffer pages
+	 */
+	voxel::BufferAllocator::Statistics getStatistics() const;
+
+	/**
+	 * @return synchronization statistics of the stream buffer
+	 */
+	const voxel::RingBuffer::Statistics& getStreamStatistics() const;
+
+	/**
+	 * @return number of meshes drawn by the last call of drawQueued
+	 */
+	std::size_t getLastDrawnMeshes() const;
+
+	/**
+	 * @return number of triangles drawn by the last call of drawQueued
+	 */
+	std::size_t getLastDrawnTriangles() const;
+
+	/**
+	 * @return number of draw calls issued by the last call of drawQueued, one per page with queued meshes
+	 */
+	std::size_t getLastDrawCalls() const;
+
+	/**
+	 * @return number of GL state changes made by the last call of drawQueued, independent of the number of meshes
+	 */
+	std::size_t getLastStateChanges() const;
+};
+
+
+#endif // !VERTEX_ARENA_H
@@ -0,0 +1,185 @@
+#ifndef VISIBILITY_GRAPH_H
+#define VISIBILITY_GRAPH_H
+
+#include <glm/vec3.hpp>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "voxel/WorldGenerator.h"
+
+
+/**
+ * Cave culling: finds the chunks which can be seen from the camera through connected air, without looking at their
+ * meshes (Tommaso Checchi's "advanced cave culling").
+ *
+ * Every section of a chunk records which pairs of its six faces are connected by air within the section, found by a
+ * flood fill when the chunk is meshed. A breadth first search then starts at the section of the camera and passes from
+ * a section to its neighbour only through a face connected to the face it entered by. The search never moves in the
+ * direction opposite to a direction it has moved before, as a line of sight from the camera cannot turn back. Chunks
+ * which have no reachable section are hidden, e.g. the surface seen from a cave or a cave seen from the surface.
+ *
+ * Faces are numbered in the order of ChunkMesher::k_arrCubeFaces: top, bottom, right, left, front, back,
+ * so the opposite of a face is the face with the last bit flipped. The air above the world connects the top faces of
+ * all chunks.
+ */
+class VisibilityGraph final
+{
+public:
+	/**
+	 * Connections between the faces of a section, one bit per unordered pair of faces
+	 */
+	using Connectivity = std::uint16_t;
+
+	/**
+	 * Connections of all sections of a chunk, from the bottom up
+	 */
+	using ChunkConnectivity = std::array<Connectivity, SECTION_COUNT>;
+
+	/** Connectivity of a section in which every face is connected to every other face, e.g. an empty one */
+	static const Connectivity k_uiAllConnected = 0x7FFF;
+
+	/**
+	 * Counts of the last traversal
+	 */
+	struct Statistics
+	{
+		/** Number of sections reached */
+		std::size_t uiVisitedSections = 0;
+
+		/** Number of chunks with at least one section reached */
+		std::size_t uiReachableChunks = 0;
+	};
+
+private:
+	/**
+	 * Section waiting to be visited by the traversal
+	 */
+	struct Node
+	{
+		/** Position of the section, chunk position along x and z, section index along y */
+		glm::ivec3 xSection;
+
+		/** Face by which the section was entered, -1 for the section of the camera */
+		int iEnteredFace;
+
+		/** Directions moved in since the section of the camera, one bit per face */
+		std::uint8_t uiDirections;
+	};
+
+	/**
+	 * Offset to the neighbouring section behind each face
+	 */
+	static const std::array<glm::ivec3, 6> k_arrFaceOffsets;
+
+	/**
+	 * Lowest chunk position along x and z of the last traversal
+	 */
+	glm::ivec3 m_xMin;
+
+	/**
+	 * Number of chunks along x and z of the last traversal
+	 */
+	int m_iSizeX;
+	int m_iSizeZ;
+
+	/**
+	 * Sections reached by the last traversal, one bit per section, by chunk in the order x * m_iSizeZ + z
+	 */
+	std::vector<std::uint8_t> m_vecVisited;
+
+	/**
+	 * Sections waiting to be visited, used as a first in first out queue
+	 */
+	std::vector<Node> m_vecQueue;
+
+	/**
+	 * Counts of the last traversal
+	 */
+	Statistics m_xStatistics;
+
+public:
+	/**
+	 * Creates a graph in which no chunk is reachable
+	 */
+	VisibilityGraph();
+
+	/**
+	 * Flood fills the air of a chunk section by section and records which faces of each section it connects
+	 *
+	 * @param xChunk  Chunk to analyze
+	 * @return connections of the faces of every section
+	 */
+	static ChunkConnectivity computeConnectivity(const Chunk& xChunk);
+
+	/**
+	 * @param uiConnectivity  Connections of the faces of a section
+	 * @param iFaceA          First face
+	 * @param iFaceB          Second face, different from the first
+	 * @return whether the two faces are connected
+	 */
+	static bool isConnected(const Connectivity uiConnectivity, const int iFaceA, const int iFaceB);
+
+	/**
+	 * Finds the chunks reachable from the section of the camera within a rectangle of chunks
+	 *
+	 * @param xCameraSection  Position of the section holding the camera, its index along y may lie above or below the
+	 *                        sections of a chunk
+	 * @param iMinX           Lowest chunk position along x
+	 * @param iMinZ           Lowest chunk position along z
+	 * @param iMaxX           One more than the highest chunk position along x
+	 * @param iMaxZ           One more than the highest chunk position along z
+	 * @param fnConnectivity  Connectivity of the chunk at a position (x, 1, z), all connected for chunks which are not
+	 *                        known yet
+	 */
+	void traverse(const glm::ivec3& xCameraSection, const int iMinX, const int iMinZ, const int iMaxX, const int iMaxZ,
+		const std::function<ChunkConnectivity(const glm::ivec3&)>& fnConnectivity);
+
+	/**
+	 * @param iX  Chunk position along x
+	 * @param iZ  Chunk position along z
+	 * @return whether the last traversal reached a section of the chunk, false outside its rectangle
+	 */
+	bool isReachable(const int iX, const int iZ) const;
+
+	/**
+	 * @return counts of the last traversal
+	 */
+	const Statistics& getStatistics() const;
+
+private:
+	/**
+	 * @param iFaceA  First face
+	 * @param iFaceB  Second face, different from the first
+	 * @return bit of the pair of faces in a Connectivity
+	 */
+	static Connectivity pairBit(const int iFaceA, const int iFaceB);
+
+	/**
+	 * Flood fills the air of one section
+	 *
+	 * @param xChunk    Chunk holding the section
+	 * @param iSection  Index of the section
+	 * @return connections of the faces of the section
+	 */
+	static Connectivity computeSectionConnectivity(const Chunk& xChunk, const int iSection);
+
+	/**
+	 * Queues a section unless it is outside the rectangle or has been reached before
+	 *
+	 * @param xSection      Position of the section
+	 * @param iEnteredFace  Face by which the section is entered, -1 for the section of the camera
+	 * @param uiDirections  Directions moved in to reach the section, one bit per face
+	 */
+	void visit(const glm::ivec3& xSection, const int iEnteredFace, const std::uint8_t uiDirections);
+
+	/**
+	 * Queues the top sections of all chunks, entered from the air above the world
+	 */
+	void visitFromSky();
+};
+
+
+#endif // !VISIBILITY_GRAPH_H
@@ -1,31 +1,163 @@
 #ifndef WORLD_GENERATOR_H
 #define WORLD_GENERATOR_H
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <glm/gtx/hash.hpp>
 #include <glm/vec3.hpp>
 
-#include "PerlinNoise.h"
-#include "Tensor3.h"
+#include "BatchedPerlinNoise.h"
+#include "SectionedTensor3.h"
+#include "ThreadPool.h"
 
 const int CHUNK_SIZE = 16;
 const int CHUNK_HEIGHT = 64;
 
+// chunks are stored in vertical sections of SECTION_SIZE^3 voxels
+const int SECTION_SIZE = 16;
+const int SECTION_COUNT = CHUNK_HEIGHT / SECTION_SIZE;
+
 const int WATER_HEIGHT = CHUNK_HEIGHT / 5;
 
 const int BLOCK_AIR = 0;
 
-using Chunk = Tensor3<char, CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE>;
+// directory holding the region files of the generated chunks, relative to the working directory
+const char* const REGION_DIRECTORY = "world";
+
+// chunks are generated densely and stored palette compressed section by section
+using DenseChunk = Tensor3<char, CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE>;
+using Chunk = SectionedTensor3<CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE, SECTION_SIZE>;
 
+class RegionStore;
+
+/*
+ * Generates the terrain chunk by chunk and keeps the generated chunks.
+ * Chunks can be generated synchronously with getChunk or requested for generation on worker threads, nearest to the
+ * focus first. Generated chunks are saved to region files and loaded from them instead of being generated again, on
+ * later launches or after they were evicted. All public methods are thread safe.
+ */
 class WorldGenerator {
-    std::unordered_map<glm::ivec3, std::shared_ptr<Chunk>> chunkCache;
-    siv::PerlinNoise noise;
+public:
+    struct StoreStatistics {
+        std::size_t residentChunks = 0;
+        std::size_t residentBytes = 0;
+        std::uint64_t evictions = 0;
+        // chunks generated again after they had been evicted, among the most recent evictions
+        std::uint64_t regenerations = 0;
+        // evicted positions remembered to count regenerations
+        std::size_t trackedEvictions = 0;
+    };
+
+private:
+    struct StoredChunk {
+        std::shared_ptr<Chunk> chunk;
+        // value of accessClock when the chunk was last looked up
+        std::uint64_t lastAccess;
+        // pinned chunks are never evicted
+        int pins;
+    };
+
+    std::unordered_map<glm::ivec3, StoredChunk> chunkCache;
+    std::size_t memoryBudget;
+    std::uint64_t accessClock = 0;
+    StoreStatistics storeStatistics;
+
+    // positions of evicted chunks with the value of evictionClock at their eviction, to count regenerations. Only as
+    // many of the most recent evictions as there are resident chunks are kept, the oldest are forgotten first in the
+    // order of evictionOrder. Entries of evictionOrder whose position was regenerated or evicted again are stale.
+    std::unordered_map<glm::ivec3, std::uint64_t> evictedChunks;
+    std::deque<std::pair<glm::ivec3, std::uint64_t>> evictionOrder;
+    std::uint64_t evictionClock = 0;
+
+    BatchedPerlinNoise noise;
+
+    // noise samples evaluated so far and the time spent on them
+    mutable std::atomic<std::uint64_t> noiseSamples{0};
+    mutable std::atomic<std::uint64_t> noiseNanoseconds{0};
+
+    // guards the chunk store, the request queue and the focus
+    mutable std::mutex mutex;
+
+    // requested chunks, a heap with the chunk nearest to the focus on top
+    std::vector<glm::ivec3> requestQueue;
+
+    // chunks in the request queue or being generated
+    std::unordered_set<glm::ivec3> requestedChunks;
+
+    glm::ivec3 focus = glm::ivec3(0);
+    int focusRadius = 0;
+
+    // whether chunks are loaded from and saved to the region store
+    std::atomic<bool> persistence{true};
+
+    // declared before the thread pool, so it writes the chunks saved by the workers before it is destroyed
+    std::shared_ptr<RegionStore> regionStore;
+
+    // declared last so the workers are stopped before the members they use are destroyed
+    ThreadPool threadPool;
+
+    std::shared_ptr<Chunk> generateChunk(const glm::ivec3& position) const;
+    // loads the chunk from the region store, generating it if it has not been saved or persistence is disabled
+    std::shared_ptr<Chunk> loadOrGenerateChunk(const glm::ivec3& position, bool& generated) const;
+    // stores the loaded or generated chunk and saves it if it was generated, returns the chunk which is stored
+    std::shared_ptr<Chunk> addChunk(const glm::ivec3& position, const std::shared_ptr<Chunk>& chunk, bool generated);
+    void computeHeights(const glm::ivec3& position, int heights[CHUNK_SIZE][CHUNK_SIZE]) const;
+    void generateNextRequest();
+
+    // The following methods must be called with the mutex locked
+    std::shared_ptr<Chunk> storeChunk(const glm::ivec3& position, const std::shared_ptr<Chunk>& chunk, bool generated);
+    void evictChunks();
 
 public:
     WorldGenerator();
+
+    // Returns the chunk, generating it on the calling thread if it does not exist yet
     std::shared_ptr<Chunk> getChunk(const glm::ivec3& position);
+
+    // Returns the chunk if it has been generated and not been evicted since, an empty pointer otherwise
+    std::shared_ptr<Chunk> findChunk(const glm::ivec3& position);
+
+    // Protects the chunk from eviction until unpinChunk is called as often as pinChunk. Does nothing for chunks which
+    // are not stored.
+    void pinChunk(const glm::ivec3& position);
+    void unpinChunk(const glm::ivec3& position);
+
+    // Sets the memory the stored chunks may use. When it is exceeded, unpinned chunks outside the focus radius are
+    // evicted furthest first, then the least recently used ones.
+    void setMemoryBudget(std::size_t bytes);
+    std::size_t getMemoryBudget() const;
+
+    StoreStatistics getStoreStatistics() const;
+
+    // Queues the chunk for generation on the worker threads, does nothing if it exists or is already queued
+    void requestChunk(const glm::ivec3& position);
+
+    // Sets the position requests are prioritized against. Requests further than radius chunks away along x or z are
+    // cancelled.
+    void setFocus(const glm::ivec3& position, int radius);
+
+    // Number of chunks queued or being generated
+    std::size_t getRequestCount() const;
+
+    // Selects whether the terrain noise is evaluated with SIMD instructions when the CPU supports them
+    void setSimdNoise(bool enabled);
+    bool isSimdNoiseActive() const;
+
+    // Terrain noise throughput measured over all generated chunks
+    double getNoiseSamplesPerSecond() const;
+
+    // Selects whether chunks are loaded from and saved to region files in REGION_DIRECTORY
+    void setPersistence(bool enabled);
+    bool isPersistenceEnabled() const;
+
+    const RegionStore& getRegionStore() const;
 };
 
 #endif // !WORLD_GENERATOR_H
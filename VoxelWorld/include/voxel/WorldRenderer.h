@@ -1,23 +1,149 @@
 #ifndef WORLD_RENDERER_H
 #define WORLD_RENDERER_H
 
+#include "OcclusionCuller.h"
+#include "OcclusionQueries.h"
+#include "RegionStore.h"
 #include "RenderChunkGenerator.h"
 #include "ShaderProgram.h"
 #include "Texture.h"
+#include "VisibilityGraph.h"
 #include "WorldGenerator.h"
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
+#include <utility>
+#include <vector>
 
 class WorldRenderer {
 public:
+    // bounds of the render distance [chunks]
+    static const int MIN_RENDER_DISTANCE = 4;
+    static const int MAX_RENDER_DISTANCE = 64;
+
+    // chunk and region counts of the frustum culling in the last frame
+    struct CullingStatistics {
+        std::size_t regionsTested = 0;
+        std::size_t regionsVisible = 0;
+        // chunks tested individually, the chunks of regions completely inside the frustum are not
+        std::size_t chunksTested = 0;
+        std::size_t chunksVisible = 0;
+        double sortTime = 0.0; // ms, sorting the chunks in the frustum front to back
+        // chunks not reachable from the camera through connected air, skipped before the frustum test
+        std::size_t chunksCaveCulled = 0;
+        std::size_t sectionsTraversed = 0;
+        double caveCullingTime = 0.0; // ms
+        // chunks in the frustum hidden behind the occluders
+        std::size_t chunksOccluded = 0;
+        std::size_t occluderTriangles = 0;
+        double occlusionTime = 0.0; // ms, rasterizing the occluders and testing the chunks
+        // chunks skipped as the latest result of their occlusion query found them hidden
+        std::size_t chunksQueryOccluded = 0;
+        // drawn chunks per level of detail of their mesh
+        std::size_t chunksPerLod[RenderChunkGenerator::k_iLodCount] = {};
+    };
+
+    // uploads of new chunk meshes in the last frame
+    struct UploadStatistics {
+        std::size_t budgetBytes = 0;
+        std::size_t uploadedBytes = 0;
+        // meshes which did not fit into the budget and wait for the next frames
+        std::size_t waitingMeshes = 0;
+        double uploadTime = 0.0; // ms
+        double frameTime = 0.0;  // ms, time since the previous frame
+    };
+
     void init();
-    void render(glm::mat4 vp, glm::vec3 cameraPos, glm::vec3 cameraFront, bool wireframe);
+    void render(glm::mat4 vp, glm::vec3 cameraPos, bool wireframe);
+
+    void setMeshingMode(RenderChunkGenerator::MeshingMode meshingMode);
+    RenderChunkGenerator::MeshingMode getMeshingMode() const;
+    const RenderChunkGenerator::Statistics& getMeshingStatistics() const;
+    std::size_t getPendingMeshCount() const;
+    const LimitedUnorderedMap<glm::ivec3, RenderChunk>::Statistics& getMeshCacheStatistics() const;
+    std::size_t getCachedMeshCount() const;
+    std::size_t getCachedMeshBytes() const;
+    std::size_t getPendingChunkCount() const;
+    const CullingStatistics& getCullingStatistics() const;
+    void setCaveCulling(bool enabled);
+    bool isCaveCullingEnabled() const;
+    void setOcclusionCulling(bool enabled);
+    bool isOcclusionCullingEnabled() const;
+    void setOcclusionQueryCulling(bool enabled);
+    bool isOcclusionQueryCullingEnabled() const;
+    const OcclusionQueries::Statistics& getOcclusionQueryStatistics() const;
+    void setLevelOfDetail(bool enabled);
+    bool isLevelOfDetailEnabled() const;
+    void setLodDistance(int chunks);
+    int getLodDistance() const;
+    const VertexArena& getVertexArena() const;
+    void setRenderDistance(int chunks);
+    int getRenderDistance() const;
+    void setUploadBudget(std::size_t bytes);
+    std::size_t getUploadBudget() const;
+    void setAdaptiveUploadBudget(bool enabled);
+    bool isAdaptiveUploadBudget() const;
+    void setTargetFrameTime(double milliseconds);
+    double getTargetFrameTime() const;
+    const UploadStatistics& getUploadStatistics() const;
+    void setSimdNoise(bool enabled);
+    bool isSimdNoiseActive() const;
+    double getNoiseSamplesPerSecond() const;
+    void setChunkMemoryBudget(std::size_t bytes);
+    std::size_t getChunkMemoryBudget() const;
+    WorldGenerator::StoreStatistics getChunkStoreStatistics() const;
+    void setChunkPersistence(bool enabled);
+    bool isChunkPersistenceEnabled() const;
+    RegionStore::Statistics getRegionStatistics() const;
 
 private:
     std::shared_ptr<Texture> texture;
     ShaderProgram shaderProgram;
     WorldGenerator worldGenerator;
     std::shared_ptr<RenderChunkGenerator> renderChunkGenerator;
+    CullingStatistics cullingStatistics;
+
+    // only chunks reachable from the section of the camera through air connecting the faces of sections are drawn
+    bool caveCulling = true;
+    VisibilityGraph visibilityGraph;
+
+    // chunks in the frustum are tested against a coarse depth buffer of the solid ground of the nearest ones
+    bool occlusionCulling = true;
+    OcclusionCuller occlusionCuller;
+    // the remaining chunks are drawn only if the latest hardware occlusion query of their box found it visible
+    bool occlusionQueryCulling = true;
+    std::shared_ptr<OcclusionQueries> occlusionQueries;
+    // render chunks which passed the frustum test in the current frame, sorted front to back before they are drawn
+    std::vector<std::pair<glm::ivec3, std::shared_ptr<RenderChunk>>> visibleChunks;
+    // quantized camera distances of the visible chunks and scratch space of the radix sort
+    std::vector<std::uint16_t> sortKeys;
+    std::vector<std::uint16_t> sortedKeys;
+    std::vector<std::pair<glm::ivec3, std::shared_ptr<RenderChunk>>> sortedChunks;
+
+    // chunks are rendered up to this many chunks away from the camera along x and z
+    int renderDistance = 15;
+
+    // chunks at least lodDistance chunks away from the camera are drawn with meshes of half the resolution, every
+    // doubling of the distance halves the resolution again
+    bool levelOfDetail = true;
+    int lodDistance = 8;
+
+    // bytes of new chunk meshes uploaded per frame. If adaptive, the budget halves whenever a frame takes longer than
+    // the target frame time and grows slowly otherwise. The render distance governor of RenderLoop aims for the same
+    // target frame time.
+    std::size_t uploadBudget = 2 * 1024 * 1024;
+    bool adaptiveUploadBudget = true;
+    double targetFrameTime = 1000.0 / 60.0;
+    std::chrono::steady_clock::time_point lastFrame;
+    UploadStatistics uploadStatistics;
+
+    void adjustUploadBudget();
+    int lodForDistance(float distance) const;
+    int selectLod(const glm::ivec3& position, const glm::vec3& cameraPos) const;
+    void sortVisibleChunks(const glm::vec3& cameraPos);
+    void traverseVisibilityGraph(const glm::vec3& cameraPos, int minX, int minZ, int maxX, int maxZ);
+    void cullOccluded(const glm::mat4& vp);
 };
 
 #endif // !WORLD_RENDERER_H
@@ -1,11 +1,17 @@
-#version 410
+#version 460
 
 in vec2 frag_texture_coordinate;
+flat in vec4 frag_texture_region;
 
 out vec4 fragmentColor;
 
 uniform sampler2D model_texture;
 
 void main() {
-  fragmentColor = texture(model_texture, frag_texture_coordinate);
+  // wrap the texture coordinate into the face region, the gradients are taken from the unwrapped coordinate so the
+  // mipmap level does not jump at voxel borders
+  vec2 coordinate = frag_texture_region.xy + fract(frag_texture_coordinate) * frag_texture_region.zw;
+  vec2 gradient_x = dFdx(frag_texture_coordinate) * frag_texture_region.zw;
+  vec2 gradient_y = dFdy(frag_texture_coordinate) * frag_texture_region.zw;
+  fragmentColor = textureGrad(model_texture, coordinate, gradient_x, gradient_y);
 }
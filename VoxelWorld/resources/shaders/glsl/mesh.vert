@@ -1,13 +1,58 @@
-#version 410
+#version 460
 
-in vec3 vertex_position;
-in vec2 texture_coordinate;
+// bits 0-4: x, 5-11: y, 12-16: z + 1, 17-19: cube face (top, bottom, right, left, front, back), 20-24: atlas tile
+layout(location = 0) in uint vertex_data;
 
+// texture coordinate in voxels, repeats once per voxel
 out vec2 frag_texture_coordinate;
+// region (u, v, width, height) of the face within the texture atlas
+flat out vec4 frag_texture_region;
 
-uniform mat4 mvp;
+// world position of each chunk drawn by the multi draw calls, indexed by the base instance of its draw
+layout(std430, binding = 0) readonly buffer ChunkOffsets {
+  vec4 chunk_offsets[];
+};
+
+uniform mat4 vp;
+
+const float CHUNK_SIZE = 16.0;
+const float TEXTURE_ATLAS_SIZE = 24.0;
+const float FACE_REGION_SIZE = 0.287581;
+
+// lower left corner of each cube face within a texture tile
+const vec2 FACE_REGIONS[6] = vec2[6](
+  vec2(0.313589, 0.312806),
+  vec2(0.639435, 0.650563),
+  vec2(0.602356, 0.312428),
+  vec2(0.025154, 0.313990),
+  vec2(0.313669, 0.023656),
+  vec2(0.313199, 0.602340)
+);
 
 void main() {
-  frag_texture_coordinate = texture_coordinate;
-  gl_Position = mvp * vec4(vertex_position, 1.0);
+  vec3 p = vec3(float(bitfieldExtract(vertex_data, 0, 5)),
+                float(bitfieldExtract(vertex_data, 5, 7)),
+                float(bitfieldExtract(vertex_data, 12, 5)) - 1.0);
+  int face = int(bitfieldExtract(vertex_data, 17, 3));
+  float tile = float(bitfieldExtract(vertex_data, 20, 5));
+
+  vec2 voxel_coordinate;
+  if (face == 0) {
+    voxel_coordinate = vec2(p.x, -p.z);
+  } else if (face == 1) {
+    voxel_coordinate = vec2(p.x, p.z);
+  } else if (face == 2) {
+    voxel_coordinate = vec2(-p.y, -p.z);
+  } else if (face == 3) {
+    voxel_coordinate = vec2(p.y, -p.z);
+  } else if (face == 4) {
+    voxel_coordinate = vec2(p.x, p.y);
+  } else {
+    voxel_coordinate = vec2(p.x, -p.y);
+  }
+
+  frag_texture_coordinate = voxel_coordinate;
+  frag_texture_region = vec4((tile + FACE_REGIONS[face].x) / TEXTURE_ATLAS_SIZE, FACE_REGIONS[face].y,
+                             FACE_REGION_SIZE / TEXTURE_ATLAS_SIZE, FACE_REGION_SIZE);
+  gl_Position = vp * vec4(p / CHUNK_SIZE + chunk_offsets[gl_BaseInstance].xyz, 1.0);
 }
@@ -0,0 +1,5 @@
+#version 460
+
+// only the depth test matters, color writes are disabled while the boxes are drawn
+void main() {
+}
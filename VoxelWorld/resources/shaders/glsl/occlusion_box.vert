@@ -0,0 +1,21 @@
+#version 460
+
+// bounding box of each queried chunk, indexed by the base instance of its draw
+struct Box {
+  vec4 min_corner;
+  vec4 max_corner;
+};
+
+layout(std430, binding = 1) readonly buffer Boxes {
+  Box boxes[];
+};
+
+uniform mat4 vp;
+
+void main() {
+  // 14 vertex triangle strip covering all faces of the unit cube, the bits select the corner per vertex
+  uint bit = 1u << gl_VertexID;
+  vec3 corner = vec3((0x287au & bit) != 0u, (0x02afu & bit) != 0u, (0x31e3u & bit) != 0u);
+  Box box = boxes[gl_BaseInstance];
+  gl_Position = vp * vec4(mix(box.min_corner.xyz, box.max_corner.xyz, corner), 1.0);
+}
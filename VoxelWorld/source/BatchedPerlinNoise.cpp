@@ -0,0 +1,232 @@
+#include "BatchedPerlinNoise.h"
+
+#include <algorithm>
+#include <random>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BATCHED_PERLIN_NOISE_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#define AVX2_FUNCTION
+#else
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+
+
+constexpr double BatchedPerlinNoise::k_dTolerance;
+
+
+#if defined(BATCHED_PERLIN_NOISE_AVX2)
+
+/**
+ * Fade curve 6t^5 - 15t^4 + 10t^3, evaluated in the same order as siv::PerlinNoise::Fade
+ */
+AVX2_FUNCTION static __m256d fade(const __m256d t)
+{
+	const __m256d t3 = _mm256_mul_pd(_mm256_mul_pd(t, t), t);
+	const __m256d inner = _mm256_add_pd(_mm256_mul_pd(t, _mm256_sub_pd(_mm256_mul_pd(t, _mm256_set1_pd(6.0)), _mm256_set1_pd(15.0))), _mm256_set1_pd(10.0));
+	return _mm256_mul_pd(t3, inner);
+}
+
+
+/**
+ * Linear interpolation a + t * (b - a)
+ */
+AVX2_FUNCTION static __m256d lerp(const __m256d t, const __m256d a, const __m256d b)
+{
+	return _mm256_add_pd(a, _mm256_mul_pd(t, _mm256_sub_pd(b, a)));
+}
+
+
+/**
+ * Widens four 32 bit lane masks to 64 bit lane masks
+ */
+AVX2_FUNCTION static __m256d widenMask(const __m128i mask)
+{
+	return _mm256_castsi256_pd(_mm256_cvtepi32_epi64(mask));
+}
+
+
+/**
+ * Gradient function of siv::PerlinNoise::Grad with z = 0
+ */
+AVX2_FUNCTION static __m256d grad(const __m128i hash, const __m256d x, const __m256d y)
+{
+	const __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+
+	// u = h < 8 ? x : y
+	const __m256d u = _mm256_blendv_pd(y, x, widenMask(_mm_cmplt_epi32(h, _mm_set1_epi32(8))));
+	// v = h < 4 ? y : h == 12 || h == 14 ? x : z
+	const __m128i isX = _mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14)));
+	const __m256d vHigh = _mm256_and_pd(x, widenMask(isX));
+	const __m256d v = _mm256_blendv_pd(vHigh, y, widenMask(_mm_cmplt_epi32(h, _mm_set1_epi32(4))));
+
+	// negate u if bit 0 is set, v if bit 1 is set
+	const __m256i signU = _mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm_and_si128(h, _mm_set1_epi32(1))), 63);
+	const __m256i signV = _mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm_srli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 1)), 63);
+	return _mm256_add_pd(_mm256_xor_pd(u, _mm256_castsi256_pd(signU)), _mm256_xor_pd(v, _mm256_castsi256_pd(signV)));
+}
+
+
+/**
+ * 2D Perlin noise of four sample points, siv::PerlinNoise::noise(x, y, 0.0)
+ */
+AVX2_FUNCTION static __m256d noise(const std::int32_t* pPermutation, __m256d x, __m256d y)
+{
+	const __m256d floorX = _mm256_floor_pd(x);
+	const __m256d floorY = _mm256_floor_pd(y);
+	const __m128i mask = _mm_set1_epi32(255);
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i X = _mm_and_si128(_mm256_cvttpd_epi32(floorX), mask);
+	const __m128i Y = _mm_and_si128(_mm256_cvttpd_epi32(floorY), mask);
+
+	x = _mm256_sub_pd(x, floorX);
+	y = _mm256_sub_pd(y, floorY);
+
+	const __m256d u = fade(x);
+	const __m256d v = fade(y);
+
+	// with z = 0 the lookups of the second z layer do not contribute
+	const __m128i A = _mm_add_epi32(_mm_i32gather_epi32(pPermutation, X, 4), Y);
+	const __m128i AA = _mm_i32gather_epi32(pPermutation, A, 4);
+	const __m128i AB = _mm_i32gather_epi32(pPermutation, _mm_add_epi32(A, one), 4);
+	const __m128i B = _mm_add_epi32(_mm_i32gather_epi32(pPermutation, _mm_add_epi32(X, one), 4), Y);
+	const __m128i BA = _mm_i32gather_epi32(pPermutation, B, 4);
+	const __m128i BB = _mm_i32gather_epi32(pPermutation, _mm_add_epi32(B, one), 4);
+
+	const __m256d xMinusOne = _mm256_sub_pd(x, _mm256_set1_pd(1.0));
+	const __m256d yMinusOne = _mm256_sub_pd(y, _mm256_set1_pd(1.0));
+
+	return lerp(v,
+		lerp(u, grad(_mm_i32gather_epi32(pPermutation, AA, 4), x, y), grad(_mm_i32gather_epi32(pPermutation, BA, 4), xMinusOne, y)),
+		lerp(u, grad(_mm_i32gather_epi32(pPermutation, AB, 4), x, yMinusOne), grad(_mm_i32gather_epi32(pPermutation, BB, 4), xMinusOne, yMinusOne)));
+}
+
+
+/**
+ * octaveNoise0_1 for batches of four sample points, returns the number of evaluated points
+ */
+AVX2_FUNCTION static std::size_t octaveNoiseAvx2(const std::int32_t* pPermutation, const double* pX, const double* pY, double* pResult, const std::size_t uiCount, const std::int32_t iOctaves)
+{
+	std::size_t uiIndex = 0;
+	for (; uiIndex + 4 <= uiCount; uiIndex += 4)
+	{
+		__m256d x = _mm256_loadu_pd(pX + uiIndex);
+		__m256d y = _mm256_loadu_pd(pY + uiIndex);
+		__m256d result = _mm256_setzero_pd();
+		double dAmplitude = 1.0;
+		for (std::int32_t iOctave = 0; iOctave < iOctaves; ++iOctave)
+		{
+			result = _mm256_add_pd(result, _mm256_mul_pd(noise(pPermutation, x, y), _mm256_set1_pd(dAmplitude)));
+			x = _mm256_mul_pd(x, _mm256_set1_pd(2.0));
+			y = _mm256_mul_pd(y, _mm256_set1_pd(2.0));
+			dAmplitude *= 0.5;
+		}
+		_mm256_storeu_pd(pResult + uiIndex, _mm256_add_pd(_mm256_mul_pd(result, _mm256_set1_pd(0.5)), _mm256_set1_pd(0.5)));
+	}
+	return uiIndex;
+}
+
+#endif
+
+
+/**
+ * Constructor
+ *
+ * @param uiSeed  Seed of the permutation table
+ */
+BatchedPerlinNoise::BatchedPerlinNoise(const std::uint32_t uiSeed)
+	: m_xNoise(uiSeed), m_bSimdEnabled(true)
+{
+	// Same shuffle as siv::PerlinNoise::reseed, whose table is not accessible
+	std::uint8_t arrPermutation[256];
+	for (std::size_t uiIndex = 0; uiIndex < 256; ++uiIndex)
+	{
+		arrPermutation[uiIndex] = static_cast<std::uint8_t>(uiIndex);
+	}
+	std::shuffle(std::begin(arrPermutation), std::end(arrPermutation), std::default_random_engine(uiSeed));
+
+	for (std::size_t uiIndex = 0; uiIndex < 256; ++uiIndex)
+	{
+		m_arrPermutation[uiIndex] = arrPermutation[uiIndex];
+		m_arrPermutation[256 + uiIndex] = arrPermutation[uiIndex];
+	}
+}
+
+
+/**
+ * Evaluates octaveNoise0_1 for a batch of sample points. Thread safe.
+ *
+ * @param pX         X coordinates of the sample points
+ * @param pY         Y coordinates of the sample points
+ * @param pResult    Receives the noise values in [0, 1]
+ * @param uiCount    Number of sample points
+ * @param iOctaves   Number of octaves
+ */
+void BatchedPerlinNoise::octaveNoise0_1(const double* pX, const double* pY, double* pResult, const std::size_t uiCount, const std::int32_t iOctaves) const
+{
+	std::size_t uiIndex = 0;
+#if defined(BATCHED_PERLIN_NOISE_AVX2)
+	if (isSimdActive())
+	{
+		uiIndex = octaveNoiseAvx2(m_arrPermutation, pX, pY, pResult, uiCount, iOctaves);
+	}
+#endif
+	// scalar fallback, also handles the remainder of the SIMD batches
+	for (; uiIndex < uiCount; ++uiIndex)
+	{
+		pResult[uiIndex] = m_xNoise.octaveNoise0_1(pX[uiIndex], pY[uiIndex], iOctaves);
+	}
+}
+
+
+/**
+ * Selects whether the SIMD implementation is used when the CPU supports it
+ */
+void BatchedPerlinNoise::setSimdEnabled(const bool bEnabled)
+{
+	m_bSimdEnabled = bEnabled;
+}
+
+
+/**
+ * @return whether the SIMD implementation is currently used
+ */
+bool BatchedPerlinNoise::isSimdActive() const
+{
+	return m_bSimdEnabled && isSimdSupported();
+}
+
+
+/**
+ * @return whether the CPU supports the SIMD implementation
+ */
+bool BatchedPerlinNoise::isSimdSupported()
+{
+#if defined(BATCHED_PERLIN_NOISE_AVX2) && defined(_MSC_VER)
+	static const bool bSupported = []() {
+		int arrInfo[4];
+		__cpuid(arrInfo, 0);
+		if (arrInfo[0] < 7)
+		{
+			return false;
+		}
+		__cpuid(arrInfo, 1);
+		// the OS must save the AVX registers (OSXSAVE and XCR0)
+		const bool bOsAvx = (arrInfo[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+		__cpuidex(arrInfo, 7, 0);
+		return bOsAvx && (arrInfo[1] & (1 << 5)) != 0;
+	}();
+	return bSupported;
+#elif defined(BATCHED_PERLIN_NOISE_AVX2)
+	static const bool bSupported = __builtin_cpu_supports("avx2");
+	return bSupported;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,62 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+
+/**
+ * Extracts the planes of the frustum.
+ * Every plane is a sum or difference of the last and one of the other rows of the matrix (Gribb and Hartmann).
+ *
+ * @param xViewProjection  Matrix transforming world coordinates into OpenGL clip space
+ */
+Frustum::Frustum(const glm::mat4& xViewProjection)
+{
+	// glm matrices are column major
+	glm::vec4 arrRows[4];
+	for (int iRow = 0; iRow < 4; ++iRow)
+	{
+		arrRows[iRow] = glm::vec4(xViewProjection[0][iRow], xViewProjection[1][iRow], xViewProjection[2][iRow], xViewProjection[3][iRow]);
+	}
+
+	m_arrPlanes[0] = arrRows[3] + arrRows[0];
+	m_arrPlanes[1] = arrRows[3] - arrRows[0];
+	m_arrPlanes[2] = arrRows[3] + arrRows[1];
+	m_arrPlanes[3] = arrRows[3] - arrRows[1];
+	m_arrPlanes[4] = arrRows[3] + arrRows[2];
+	m_arrPlanes[5] = arrRows[3] - arrRows[2];
+
+	for (auto& xPlane : m_arrPlanes)
+	{
+		const float fLength = std::sqrt(xPlane.x * xPlane.x + xPlane.y * xPlane.y + xPlane.z * xPlane.z);
+		xPlane = xPlane / fLength;
+	}
+}
+
+
+/**
+ * Tests an axis aligned box against the frustum.
+ * For every plane, the corner furthest along the plane normal decides whether the box is outside, the opposite
+ * corner whether it is completely inside.
+ *
+ * @param xMin  Minimum corner of the box in world coordinates
+ * @param xMax  Maximum corner of the box in world coordinates
+ */
+Frustum::Containment Frustum::classify(const glm::vec3& xMin, const glm::vec3& xMax) const
+{
+	Containment eContainment = Containment::eInside;
+	for (const auto& xPlane : m_arrPlanes)
+	{
+		const glm::vec3 xPositive(xPlane.x >= 0.0f ? xMax.x : xMin.x, xPlane.y >= 0.0f ? xMax.y : xMin.y, xPlane.z >= 0.0f ? xMax.z : xMin.z);
+		const glm::vec3 xNegative(xPlane.x >= 0.0f ? xMin.x : xMax.x, xPlane.y >= 0.0f ? xMin.y : xMax.y, xPlane.z >= 0.0f ? xMin.z : xMax.z);
+
+		if (xPlane.x * xPositive.x + xPlane.y * xPositive.y + xPlane.z * xPositive.z + xPlane.w < 0.0f)
+		{
+			return Containment::eOutside;
+		}
+		if (xPlane.x * xNegative.x + xPlane.y * xNegative.y + xPlane.z * xNegative.z + xPlane.w < 0.0f)
+		{
+			eContainment = Containment::eIntersecting;
+		}
+	}
+	return eContainment;
+}
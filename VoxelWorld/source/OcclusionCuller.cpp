@@ -0,0 +1,353 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OCCLUSION_CULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace
+{
+
+/** Corners of the faces of a box, counter-clockwise when seen from outside, bit 0 to 2 select the maximum x, y and z */
+const int k_arrFaces[6][4] =
+{
+	{ 0, 4, 6, 2 },
+	{ 1, 3, 7, 5 },
+	{ 0, 1, 5, 4 },
+	{ 2, 6, 7, 3 },
+	{ 0, 2, 3, 1 },
+	{ 4, 5, 7, 6 }
+};
+
+/** Depth subtracted from the nearest depth of a tested box, against rounding errors */
+const float k_fDepthBias = 1.0e-6f;
+
+/**
+ * @param xMin    Minimum corner of the box
+ * @param xMax    Maximum corner of the box
+ * @param iIndex  Index of the corner, bit 0 to 2 select the maximum x, y and z
+ * @return corner of the box
+ */
+glm::vec3 corner(const glm::vec3& xMin, const glm::vec3& xMax, const int iIndex)
+{
+	return glm::vec3((iIndex & 1) ? xMax.x : xMin.x, (iIndex & 2) ? xMax.y : xMin.y, (iIndex & 4) ? xMax.z : xMin.z);
+}
+
+}
+
+
+/**
+ * Allocates the depth buffer and the levels of its hierarchy down to a single row
+ */
+OcclusionCuller::OcclusionCuller()
+	: m_xViewProjection(1.0f), m_uiTriangles(0)
+{
+	for (int iWidth = k_iWidth, iHeight = k_iHeight; iWidth >= 1 && iHeight >= 1; iWidth /= 2, iHeight /= 2)
+	{
+		m_vecLevels.emplace_back(static_cast<std::size_t>(iWidth * iHeight), 1.0f);
+	}
+}
+
+
+/**
+ * Clears the depth buffer to the far plane
+ *
+ * @param xViewProjection  Matrix transforming world coordinates into OpenGL clip space
+ */
+void OcclusionCuller::begin(const glm::mat4& xViewProjection)
+{
+	m_xViewProjection = xViewProjection;
+	std::fill(m_vecLevels[0].begin(), m_vecLevels[0].end(), 1.0f);
+	m_uiTriangles = 0;
+}
+
+
+/**
+ * Rasterizes the faces of a box into the depth buffer, skipping boxes completely outside one of the clip planes
+ * other than the near plane. Faces pointing away from the camera are culled by the rasterizer.
+ *
+ * @param xMin  Minimum corner of the box in world coordinates
+ * @param xMax  Maximum corner of the box in world coordinates
+ */
+void OcclusionCuller::addOccluder(const glm::vec3& xMin, const glm::vec3& xMax)
+{
+	ClipVertex arrCorners[8];
+	int iOutsideMask = 0x1F;
+	for (int iCorner = 0; iCorner < 8; ++iCorner)
+	{
+		const ClipVertex& xClip = arrCorners[iCorner] = m_xViewProjection * glm::vec4(corner(xMin, xMax, iCorner), 1.0f);
+		const int iOutside = (xClip.x < -xClip.w ? 0x01 : 0) | (xClip.x > xClip.w ? 0x02 : 0) | (xClip.y < -xClip.w ? 0x04 : 0)
+			| (xClip.y > xClip.w ? 0x08 : 0) | (xClip.z > xClip.w ? 0x10 : 0);
+		iOutsideMask &= iOutside;
+	}
+	if (iOutsideMask != 0)
+	{
+		return;
+	}
+
+	for (const auto& arrFace : k_arrFaces)
+	{
+		clipTriangle(arrCorners[arrFace[0]], arrCorners[arrFace[1]], arrCorners[arrFace[2]]);
+		clipTriangle(arrCorners[arrFace[0]], arrCorners[arrFace[2]], arrCorners[arrFace[3]]);
+	}
+}
+
+
+/**
+ * Builds the hierarchy, every texel holds the farthest of the four texels it covers on the previous level
+ */
+void OcclusionCuller::finishOccluders()
+{
+	for (std::size_t uiLevel = 1; uiLevel < m_vecLevels.size(); ++uiLevel)
+	{
+		const std::vector<float>& vecSource = m_vecLevels[uiLevel - 1];
+		std::vector<float>& vecTarget = m_vecLevels[uiLevel];
+		const int iSourceWidth = k_iWidth >> (uiLevel - 1);
+		const int iWidth = k_iWidth >> uiLevel;
+		const int iHeight = k_iHeight >> uiLevel;
+		for (int iY = 0; iY < iHeight; ++iY)
+		{
+			const float* pRow0 = &vecSource[static_cast<std::size_t>(2 * iY * iSourceWidth)];
+			const float* pRow1 = pRow0 + iSourceWidth;
+			float* pTarget = &vecTarget[static_cast<std::size_t>(iY * iWidth)];
+			for (int iX = 0; iX < iWidth; ++iX)
+			{
+				pTarget[iX] = std::max(std::max(pRow0[2 * iX], pRow0[2 * iX + 1]), std::max(pRow1[2 * iX], pRow1[2 * iX + 1]));
+			}
+		}
+	}
+}
+
+
+/**
+ * Tests the nearest depth of a box against the texels covered by its screen rectangle. The level is chosen so the
+ * rectangle covers at most four by four texels. Boxes outside the screen are left to the frustum test.
+ *
+ * @param xMin  Minimum corner of the box in world coordinates
+ * @param xMax  Maximum corner of the box in world coordinates
+ */
+bool OcclusionCuller::isOccluded(const glm::vec3& xMin, const glm::vec3& xMax) const
+{
+	float fMinX = std::numeric_limits<float>::max();
+	float fMinY = std::numeric_limits<float>::max();
+	float fMaxX = std::numeric_limits<float>::lowest();
+	float fMaxY = std::numeric_limits<float>::lowest();
+	float fNearest = 1.0f;
+	for (int iCorner = 0; iCorner < 8; ++iCorner)
+	{
+		const ClipVertex xClip = m_xViewProjection * glm::vec4(corner(xMin, xMax, iCorner), 1.0f);
+		if (xClip.z < -xClip.w)
+		{
+			return false;
+		}
+		const float fInverseW = 1.0f / xClip.w;
+		const float fX = (xClip.x * fInverseW * 0.5f + 0.5f) * k_iWidth;
+		const float fY = (xClip.y * fInverseW * 0.5f + 0.5f) * k_iHeight;
+		fMinX = std::min(fMinX, fX);
+		fMinY = std::min(fMinY, fY);
+		fMaxX = std::max(fMaxX, fX);
+		fMaxY = std::max(fMaxY, fY);
+		fNearest = std::min(fNearest, xClip.z * fInverseW * 0.5f + 0.5f);
+	}
+
+	// Pixels touched by the rectangle
+	const int iMinX = std::max(0, static_cast<int>(std::floor(fMinX)));
+	const int iMinY = std::max(0, static_cast<int>(std::floor(fMinY)));
+	const int iMaxX = std::min(k_iWidth - 1, static_cast<int>(std::floor(fMaxX)));
+	const int iMaxY = std::min(k_iHeight - 1, static_cast<int>(std::floor(fMaxY)));
+	if (iMinX > iMaxX || iMinY > iMaxY)
+	{
+		return false;
+	}
+
+	int iLevel = 0;
+	while (iLevel + 1 < static_cast<int>(m_vecLevels.size()) && ((iMaxX >> iLevel) - (iMinX >> iLevel) > 3 || (iMaxY >> iLevel) - (iMinY >> iLevel) > 3))
+	{
+		++iLevel;
+	}
+
+	const std::vector<float>& vecLevel = m_vecLevels[static_cast<std::size_t>(iLevel)];
+	const int iWidth = k_iWidth >> iLevel;
+	const float fDepth = fNearest - k_fDepthBias;
+	for (int iY = iMinY >> iLevel; iY <= iMaxY >> iLevel; ++iY)
+	{
+		for (int iX = iMinX >> iLevel; iX <= iMaxX >> iLevel; ++iX)
+		{
+			if (vecLevel[static_cast<std::size_t>(iY * iWidth + iX)] >= fDepth)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+/**
+ * @return number of triangles rasterized since begin, after back face culling and clipping
+ */
+std::size_t OcclusionCuller::getTriangleCount() const
+{
+	return m_uiTriangles;
+}
+
+
+/**
+ * Clips a triangle against the near plane (z = -w) and rasterizes the remaining polygon, which has up to four corners.
+ *
+ * @param xA  First vertex in clip space
+ * @param xB  Second vertex in clip space
+ * @param xC  Third vertex in clip space, counter-clockwise when seen from outside the box
+ */
+void OcclusionCuller::clipTriangle(const ClipVertex& xA, const ClipVertex& xB, const ClipVertex& xC)
+{
+	const ClipVertex arrInput[3] = { xA, xB, xC };
+	ClipVertex arrOutput[4];
+	int iOutputCount = 0;
+	for (int iVertex = 0; iVertex < 3; ++iVertex)
+	{
+		const ClipVertex& xCurrent = arrInput[iVertex];
+		const ClipVertex& xNext = arrInput[(iVertex + 1) % 3];
+		const float fCurrent = xCurrent.z + xCurrent.w;
+		const float fNext = xNext.z + xNext.w;
+		if (fCurrent >= 0.0f)
+		{
+			arrOutput[iOutputCount++] = xCurrent;
+		}
+		if ((fCurrent >= 0.0f) != (fNext >= 0.0f))
+		{
+			arrOutput[iOutputCount++] = xCurrent + (xNext - xCurrent) * (fCurrent / (fCurrent - fNext));
+		}
+	}
+
+	if (iOutputCount >= 3)
+	{
+		rasterizeTriangle(arrOutput[0], arrOutput[1], arrOutput[2]);
+	}
+	if (iOutputCount == 4)
+	{
+		rasterizeTriangle(arrOutput[0], arrOutput[2], arrOutput[3]);
+	}
+}
+
+
+/**
+ * Rasterizes a triangle with edge functions, testing pixel centers.
+ * The edge functions are moved inwards by half a pixel, so only pixels completely covered by the triangle are written,
+ * and the depth is the farthest depth of the triangle within the pixel. On x86-64 four pixels are processed at once.
+ *
+ * @param xA  First vertex in clip space
+ * @param xB  Second vertex in clip space
+ * @param xC  Third vertex in clip space
+ */
+void OcclusionCuller::rasterizeTriangle(const ClipVertex& xA, const ClipVertex& xB, const ClipVertex& xC)
+{
+	// Screen coordinates [pixels] with the origin in the lower left corner, and depths in [0, 1]
+	glm::vec3 arrScreen[3];
+	const ClipVertex* arrClip[3] = { &xA, &xB, &xC };
+	for (int iVertex = 0; iVertex < 3; ++iVertex)
+	{
+		const float fInverseW = 1.0f / arrClip[iVertex]->w;
+		arrScreen[iVertex] = glm::vec3((arrClip[iVertex]->x * fInverseW * 0.5f + 0.5f) * k_iWidth,
+			(arrClip[iVertex]->y * fInverseW * 0.5f + 0.5f) * k_iHeight, arrClip[iVertex]->z * fInverseW * 0.5f + 0.5f);
+	}
+
+	// Twice the signed area, not positive for triangles facing away from the camera
+	const float fArea = (arrScreen[1].x - arrScreen[0].x) * (arrScreen[2].y - arrScreen[0].y)
+		- (arrScreen[1].y - arrScreen[0].y) * (arrScreen[2].x - arrScreen[0].x);
+	if (!(fArea > 0.0f))
+	{
+		return;
+	}
+
+	const int iMinX = std::max(0, static_cast<int>(std::floor(std::min(std::min(arrScreen[0].x, arrScreen[1].x), arrScreen[2].x))));
+	const int iMinY = std::max(0, static_cast<int>(std::floor(std::min(std::min(arrScreen[0].y, arrScreen[1].y), arrScreen[2].y))));
+	const int iMaxX = std::min(k_iWidth - 1, static_cast<int>(std::ceil(std::max(std::max(arrScreen[0].x, arrScreen[1].x), arrScreen[2].x))) - 1);
+	const int iMaxY = std::min(k_iHeight - 1, static_cast<int>(std::ceil(std::max(std::max(arrScreen[0].y, arrScreen[1].y), arrScreen[2].y))) - 1);
+	if (iMinX > iMaxX || iMinY > iMaxY)
+	{
+		return;
+	}
+	m_uiTriangles++;
+
+	// Edge function i is positive on the inner side of the edge opposite of vertex i: fA * x + fB * y + fC
+	float arrEdgeA[3];
+	float arrEdgeB[3];
+	float arrEdgeC[3];
+	for (int iEdge = 0; iEdge < 3; ++iEdge)
+	{
+		const glm::vec3& xFrom = arrScreen[(iEdge + 1) % 3];
+		const glm::vec3& xTo = arrScreen[(iEdge + 2) % 3];
+		arrEdgeA[iEdge] = xFrom.y - xTo.y;
+		arrEdgeB[iEdge] = xTo.x - xFrom.x;
+		arrEdgeC[iEdge] = xFrom.x * xTo.y - xTo.x * xFrom.y;
+	}
+
+	// Depth plane from the barycentric coordinates, moved to the farthest depth within a pixel
+	const float fInverseArea = 1.0f / fArea;
+	float fDepthA = 0.0f;
+	float fDepthB = 0.0f;
+	float fDepthC = 0.0f;
+	for (int iEdge = 0; iEdge < 3; ++iEdge)
+	{
+		fDepthA += arrEdgeA[iEdge] * arrScreen[iEdge].z * fInverseArea;
+		fDepthB += arrEdgeB[iEdge] * arrScreen[iEdge].z * fInverseArea;
+		fDepthC += arrEdgeC[iEdge] * arrScreen[iEdge].z * fInverseArea;
+	}
+	fDepthC += 0.5f * (std::abs(fDepthA) + std::abs(fDepthB));
+	const float fMaxDepth = std::max(std::max(arrScreen[0].z, arrScreen[1].z), arrScreen[2].z);
+
+	for (int iEdge = 0; iEdge < 3; ++iEdge)
+	{
+		arrEdgeC[iEdge] -= 0.5f * (std::abs(arrEdgeA[iEdge]) + std::abs(arrEdgeB[iEdge]));
+	}
+
+	std::vector<float>& vecDepth = m_vecLevels[0];
+	for (int iY = iMinY; iY <= iMaxY; ++iY)
+	{
+		const float fY = static_cast<float>(iY) + 0.5f;
+		float* pRow = &vecDepth[static_cast<std::size_t>(iY * k_iWidth)];
+		const float fRow0 = arrEdgeB[0] * fY + arrEdgeC[0];
+		const float fRow1 = arrEdgeB[1] * fY + arrEdgeC[1];
+		const float fRow2 = arrEdgeB[2] * fY + arrEdgeC[2];
+		const float fRowDepth = fDepthB * fY + fDepthC;
+
+#ifdef OCCLUSION_CULLER_SSE2
+		// Groups of four pixels starting at a multiple of four, the width is one too
+		const __m128 xStep = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 xZero = _mm_setzero_ps();
+		const __m128 xMaxDepth = _mm_set1_ps(fMaxDepth);
+		for (int iX = iMinX & ~3; iX <= iMaxX; iX += 4)
+		{
+			const __m128 xX = _mm_add_ps(_mm_set1_ps(static_cast<float>(iX)), xStep);
+			const __m128 xEdge0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(arrEdgeA[0]), xX), _mm_set1_ps(fRow0));
+			const __m128 xEdge1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(arrEdgeA[1]), xX), _mm_set1_ps(fRow1));
+			const __m128 xEdge2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(arrEdgeA[2]), xX), _mm_set1_ps(fRow2));
+			const __m128 xInside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(xEdge0, xZero), _mm_cmpge_ps(xEdge1, xZero)), _mm_cmpge_ps(xEdge2, xZero));
+			if (_mm_movemask_ps(xInside) == 0)
+			{
+				continue;
+			}
+			const __m128 xDepth = _mm_min_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(fDepthA), xX), _mm_set1_ps(fRowDepth)), xMaxDepth);
+			const __m128 xOld = _mm_loadu_ps(pRow + iX);
+			const __m128 xNew = _mm_min_ps(xOld, xDepth);
+			_mm_storeu_ps(pRow + iX, _mm_or_ps(_mm_and_ps(xInside, xNew), _mm_andnot_ps(xInside, xOld)));
+		}
+#else
+		for (int iX = iMinX; iX <= iMaxX; ++iX)
+		{
+			const float fX = static_cast<float>(iX) + 0.5f;
+			if (arrEdgeA[0] * fX + fRow0 >= 0.0f && arrEdgeA[1] * fX + fRow1 >= 0.0f && arrEdgeA[2] * fX + fRow2 >= 0.0f)
+			{
+				const float fDepth = std::min(fDepthA * fX + fRowDepth, fMaxDepth);
+				pRow[iX] = std::min(pRow[iX], fDepth);
+			}
+		}
+#endif
+	}
+}
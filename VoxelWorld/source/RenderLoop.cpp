@@ -49,7 +49,7 @@ void RenderLoop::initGlfw() {
     }
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_SAMPLES, 4);
 
@@ -117,9 +117,11 @@ void RenderLoop::initCamera() {
 
 void RenderLoop::mainLoop() {
     bool wireframe = false;
+    bool simdNoise = true;
 
     WorldRenderer worldRenderer;
     worldRenderer.init();
+    bool chunkPersistence = worldRenderer.isChunkPersistenceEnabled();
 
     const std::uint32_t uiMaxFrameTimes = 10;
     std::vector<float> vecFrameTimes(uiMaxFrameTimes);
@@ -139,7 +141,7 @@ void RenderLoop::mainLoop() {
 
         // draw cube
         glm::mat4 vp = this->projectionMatrix * view;
-        worldRenderer.render(vp, this->cameraPos, this->cameraFront, wireframe);
+        worldRenderer.render(vp, this->cameraPos, wireframe);
 
         if (drawGui) {
             // draw gui
@@ -148,6 +150,163 @@ void RenderLoop::mainLoop() {
             ImGui::NewFrame();
             ImGui::Checkbox("Wireframe", &wireframe);
             ImGui::SliderFloat("Camera Speed", &this->cameraSpeed, 0.0f, 10.0f);
+            const char* const meshingModes[] = {"Naive", "Greedy", "Binary"};
+            int meshingMode = static_cast<int>(worldRenderer.getMeshingMode());
+            if (ImGui::Combo("Meshing", &meshingMode, meshingModes, IM_ARRAYSIZE(meshingModes))) {
+                worldRenderer.setMeshingMode(static_cast<RenderChunkGenerator::MeshingMode>(meshingMode));
+            }
+            const auto& meshingStatistics = worldRenderer.getMeshingStatistics();
+            ImGui::Text("%s", fmt::format("Chunk vertices: {} (naive {}), total: {} (naive {})",
+                                          meshingStatistics.uiLastVertices, meshingStatistics.uiLastNaiveVertices,
+                                          meshingStatistics.uiTotalVertices, meshingStatistics.uiTotalNaiveVertices).c_str());
+            if (meshingStatistics.uiTotalNaiveVertices > 0) {
+                ImGui::Text("%s", fmt::format("Vertex reduction: {:.1f}%",
+                                              100.0 - 100.0 * static_cast<double>(meshingStatistics.uiTotalVertices) /
+                                                          static_cast<double>(meshingStatistics.uiTotalNaiveVertices)).c_str());
+            }
+            if (meshingStatistics.uiMeshedChunks > 0) {
+                ImGui::Text("%s", fmt::format("Meshing time: last {:.3f} ms, average {:.3f} ms",
+                                              1000.0 * meshingStatistics.dLastMeshingTime,
+                                              1000.0 * meshingStatistics.dTotalMeshingTime /
+                                                  static_cast<double>(meshingStatistics.uiMeshedChunks)).c_str());
+            }
+            if (meshingStatistics.uiMeshedChunks > 0) {
+                ImGui::Text("%s", fmt::format("Sections skipped: {:.1f}%",
+                                              100.0 * static_cast<double>(meshingStatistics.uiSkippedSections) /
+                                                  static_cast<double>(meshingStatistics.uiMeshedChunks * SECTION_COUNT)).c_str());
+            }
+            const auto& cullingStatistics = worldRenderer.getCullingStatistics();
+            ImGui::Text("%s", fmt::format("Regions visible: {} of {}, chunks visible: {} ({} tested)",
+                                          cullingStatistics.regionsVisible, cullingStatistics.regionsTested,
+                                          cullingStatistics.chunksVisible, cullingStatistics.chunksTested).c_str());
+            bool caveCulling = worldRenderer.isCaveCullingEnabled();
+            if (ImGui::Checkbox("Cave culling", &caveCulling)) {
+                worldRenderer.setCaveCulling(caveCulling);
+            }
+            if (caveCulling) {
+                ImGui::Text("%s", fmt::format("Chunks unreachable: {}, {} sections traversed in {:.2f} ms",
+                                              cullingStatistics.chunksCaveCulled, cullingStatistics.sectionsTraversed,
+                                              cullingStatistics.caveCullingTime).c_str());
+            }
+            bool occlusionCulling = worldRenderer.isOcclusionCullingEnabled();
+            if (ImGui::Checkbox("Occlusion culling", &occlusionCulling)) {
+                worldRenderer.setOcclusionCulling(occlusionCulling);
+            }
+            if (occlusionCulling) {
+                ImGui::Text("%s", fmt::format("Chunks occluded: {}, {} occluder triangles in {:.2f} ms",
+                                              cullingStatistics.chunksOccluded, cullingStatistics.occluderTriangles,
+                                              cullingStatistics.occlusionTime).c_str());
+            }
+            bool occlusionQueryCulling = worldRenderer.isOcclusionQueryCullingEnabled();
+            if (ImGui::Checkbox("Occlusion queries", &occlusionQueryCulling)) {
+                worldRenderer.setOcclusionQueryCulling(occlusionQueryCulling);
+            }
+            if (occlusionQueryCulling) {
+                const auto& queryStatistics = worldRenderer.getOcclusionQueryStatistics();
+                ImGui::Text("%s", fmt::format("Chunks hidden by queries: {}, {} queries issued, {} results read",
+                                              cullingStatistics.chunksQueryOccluded, queryStatistics.uiIssued,
+                                              queryStatistics.uiResults).c_str());
+            }
+            bool levelOfDetail = worldRenderer.isLevelOfDetailEnabled();
+            if (ImGui::Checkbox("Level of detail", &levelOfDetail)) {
+                worldRenderer.setLevelOfDetail(levelOfDetail);
+            }
+            if (levelOfDetail) {
+                int lodDistance = worldRenderer.getLodDistance();
+                if (ImGui::SliderInt("LOD distance (chunks)", &lodDistance, 2, WorldRenderer::MAX_RENDER_DISTANCE)) {
+                    worldRenderer.setLodDistance(lodDistance);
+                }
+                ImGui::Text("%s", fmt::format("Chunks per level of detail: {} / {} / {} / {}, {} downsampled meshes",
+                                              cullingStatistics.chunksPerLod[0], cullingStatistics.chunksPerLod[1],
+                                              cullingStatistics.chunksPerLod[2], cullingStatistics.chunksPerLod[3],
+                                              meshingStatistics.uiDownsampledChunks).c_str());
+            }
+            const auto& vertexArena = worldRenderer.getVertexArena();
+            const auto arenaStatistics = vertexArena.getStatistics();
+            ImGui::Text("%s", fmt::format("Vertex pages: {:.1f} of {:.1f} MiB in {} pages",
+                                          static_cast<double>(arenaStatistics.uiUsed) / (1024.0 * 1024.0),
+                                          static_cast<double>(arenaStatistics.uiCapacity) / (1024.0 * 1024.0),
+                                          arenaStatistics.uiPageCount).c_str());
+            if (meshingStatistics.uiFailedUploads > 0) {
+                ImGui::Text("%s", fmt::format("Failed uploads: {}", meshingStatistics.uiFailedUploads).c_str());
+            }
+            ImGui::Text("%s", fmt::format("Draws: {} chunks ({} triangles) in {} draw calls, {} state changes, sorted in {:.3f} ms",
+                                          vertexArena.getLastDrawnMeshes(), vertexArena.getLastDrawnTriangles(),
+                                          vertexArena.getLastDrawCalls(), vertexArena.getLastStateChanges(),
+                                          cullingStatistics.sortTime).c_str());
+            ImGui::Text("%s", fmt::format("Vertex fragmentation: {:.0f}%, {} free ranges, {:.1f} MiB compacted",
+                                          static_cast<double>(arenaStatistics.fFragmentation) * 100.0,
+                                          arenaStatistics.uiFreeRangeCount,
+                                          static_cast<double>(arenaStatistics.uiMovedBytes) / (1024.0 * 1024.0)).c_str());
+            const auto& streamStatistics = vertexArena.getStreamStatistics();
+            ImGui::Text("%s", fmt::format("Stream buffer: {} fence waits ({:.1f} ms) over {} fences",
+                                          streamStatistics.uiFenceWaits, streamStatistics.dFenceWaitTime,
+                                          streamStatistics.uiFences).c_str());
+            ImGui::Text("%s", fmt::format("Chunks waiting for generation: {}", worldRenderer.getPendingChunkCount()).c_str());
+            ImGui::Text("%s", fmt::format("Chunks waiting for meshing: {}", worldRenderer.getPendingMeshCount()).c_str());
+            const auto& uploadStatistics = worldRenderer.getUploadStatistics();
+            ImGui::Text("%s", fmt::format("Mesh uploads: {:.0f} of {:.0f} KiB in {:.2f} ms, {} waiting, frame {:.1f} ms",
+                                          static_cast<double>(uploadStatistics.uploadedBytes) / 1024.0,
+                                          static_cast<double>(uploadStatistics.budgetBytes) / 1024.0,
+                                          uploadStatistics.uploadTime, uploadStatistics.waitingMeshes,
+                                          uploadStatistics.frameTime).c_str());
+            float targetFrameTime = static_cast<float>(worldRenderer.getTargetFrameTime());
+            if (ImGui::SliderFloat("Target frame time (ms)", &targetFrameTime, 4.0f, 50.0f)) {
+                worldRenderer.setTargetFrameTime(static_cast<double>(targetFrameTime));
+            }
+            ImGui::Checkbox("Adaptive render distance", &adaptiveRenderDistance);
+            int renderDistance = worldRenderer.getRenderDistance();
+            if (ImGui::SliderInt("Render distance (chunks)", &renderDistance, WorldRenderer::MIN_RENDER_DISTANCE,
+                                 WorldRenderer::MAX_RENDER_DISTANCE)) {
+                worldRenderer.setRenderDistance(renderDistance);
+                framesSinceRenderDistanceChange = 0;
+            }
+            bool adaptiveUploadBudget = worldRenderer.isAdaptiveUploadBudget();
+            if (ImGui::Checkbox("Adaptive upload budget", &adaptiveUploadBudget)) {
+                worldRenderer.setAdaptiveUploadBudget(adaptiveUploadBudget);
+            }
+            if (!adaptiveUploadBudget) {
+                int uploadBudget = static_cast<int>(worldRenderer.getUploadBudget() / 1024);
+                if (ImGui::SliderInt("Upload budget (KiB)", &uploadBudget, 64, 32 * 1024)) {
+                    worldRenderer.setUploadBudget(static_cast<std::size_t>(uploadBudget) * 1024);
+                }
+            }
+            const auto& meshCacheStatistics = worldRenderer.getMeshCacheStatistics();
+            ImGui::Text("%s", fmt::format("Mesh cache: {} chunks ({:.1f} MiB), hits: {}, misses: {}, evictions: {}",
+                                          worldRenderer.getCachedMeshCount(),
+                                          static_cast<double>(worldRenderer.getCachedMeshBytes()) / (1024.0 * 1024.0),
+                                          meshCacheStatistics.hits, meshCacheStatistics.misses,
+                                          meshCacheStatistics.evictions).c_str());
+
+            int chunkMemoryBudget = static_cast<int>(worldRenderer.getChunkMemoryBudget() / (1024 * 1024));
+            if (ImGui::SliderInt("Chunk memory (MiB)", &chunkMemoryBudget, 8, 512)) {
+                worldRenderer.setChunkMemoryBudget(static_cast<std::size_t>(chunkMemoryBudget) * 1024 * 1024);
+            }
+            const auto storeStatistics = worldRenderer.getChunkStoreStatistics();
+            ImGui::Text("%s", fmt::format("Chunks resident: {} ({:.1f} MiB), evicted: {} ({} tracked), regenerated: {}",
+                                          storeStatistics.residentChunks,
+                                          static_cast<double>(storeStatistics.residentBytes) / (1024.0 * 1024.0),
+                                          storeStatistics.evictions, storeStatistics.trackedEvictions,
+                                          storeStatistics.regenerations).c_str());
+
+            if (ImGui::Checkbox("Persist chunks", &chunkPersistence)) {
+                worldRenderer.setChunkPersistence(chunkPersistence);
+            }
+            const auto regionStatistics = worldRenderer.getRegionStatistics();
+            ImGui::Text("%s", fmt::format("Region files: {} loaded ({:.3f} ms avg), {} saved ({:.1f} KiB), {} queued, {} failed",
+                                          regionStatistics.uiLoadedChunks,
+                                          regionStatistics.uiLoadedChunks == 0 ? 0.0 :
+                                              regionStatistics.dLoadTime * 1000.0 / static_cast<double>(regionStatistics.uiLoadedChunks),
+                                          regionStatistics.uiSavedChunks,
+                                          static_cast<double>(regionStatistics.uiSavedBytes) / 1024.0,
+                                          regionStatistics.uiQueuedWrites, regionStatistics.uiFailedWrites).c_str());
+
+            if (ImGui::Checkbox("SIMD noise", &simdNoise)) {
+                worldRenderer.setSimdNoise(simdNoise);
+            }
+            ImGui::Text("%s", fmt::format("Terrain noise: {}, {:.2f} Msamples/s",
+                                          worldRenderer.isSimdNoiseActive() ? "AVX2" : "scalar",
+                                          worldRenderer.getNoiseSamplesPerSecond() / 1e6).c_str());
             const float fAverageTime =
                 std::accumulate(std::begin(vecFrameTimes), std::end(vecFrameTimes), 0.0f) / vecFrameTimes.size();
             ImGui::Text("FPS: %g", 1.0 / fAverageTime);
@@ -167,11 +326,34 @@ void RenderLoop::mainLoop() {
         dLastTime = dCurrentTime;
         vecFrameTimes[uiNextIndex] = static_cast<float>(dFrameTime);
         uiNextIndex = (uiNextIndex + 1) % uiMaxFrameTimes;
+
+        framesSinceRenderDistanceChange++;
+        if (adaptiveRenderDistance && framesSinceRenderDistanceChange >= uiMaxFrameTimes) {
+            const float averageFrameTime =
+                std::accumulate(std::begin(vecFrameTimes), std::end(vecFrameTimes), 0.0f) / static_cast<float>(uiMaxFrameTimes);
+            governRenderDistance(worldRenderer, averageFrameTime);
+        }
     }
 
     glfwTerminate();
 }
 
+// Shrinks the render distance if the average frame time is clearly above the target and grows it if it is clearly
+// below. The band in between keeps the distance from oscillating between two values.
+void RenderLoop::governRenderDistance(WorldRenderer& worldRenderer, float averageFrameTime) {
+    const double averageMilliseconds = 1000.0 * static_cast<double>(averageFrameTime);
+    const double target = worldRenderer.getTargetFrameTime();
+    const int renderDistance = worldRenderer.getRenderDistance();
+    if (averageMilliseconds > target * 1.15) {
+        worldRenderer.setRenderDistance(renderDistance - 1);
+    } else if (averageMilliseconds < target * 0.75) {
+        worldRenderer.setRenderDistance(renderDistance + 1);
+    }
+    if (worldRenderer.getRenderDistance() != renderDistance) {
+        framesSinceRenderDistanceChange = 0;
+    }
+}
+
 void RenderLoop::handleInput() {
     static bool ctrlDown = false;
 
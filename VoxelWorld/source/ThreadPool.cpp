@@ -0,0 +1,112 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <utility>
+
+
+/**
+ * Starts the worker threads
+ *
+ * @param uiThreads  Number of worker threads, at least one thread is started
+ */
+ThreadPool::ThreadPool(const std::size_t uiThreads)
+	: m_bStop(false)
+{
+	const std::size_t uiCount = std::max<std::size_t>(uiThreads, 1);
+	m_vecThreads.reserve(uiCount);
+	for (std::size_t uiThread = 0; uiThread < uiCount; ++uiThread)
+	{
+		m_vecThreads.emplace_back(&ThreadPool::work, this);
+	}
+}
+
+
+/**
+ * Destructor
+ * Drops the tasks which have not been started yet and waits for the running ones
+ */
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> xLock(m_xMutex);
+		m_bStop = true;
+		m_deqTasks.clear();
+	}
+	m_xCondition.notify_all();
+	for (auto& xThread : m_vecThreads)
+	{
+		xThread.join();
+	}
+}
+
+
+/**
+ * Queues a task, it is run on one of the worker threads
+ *
+ * @param fnTask  Task to run
+ */
+void ThreadPool::submit(std::function<void()> fnTask)
+{
+	{
+		std::lock_guard<std::mutex> xLock(m_xMutex);
+		m_deqTasks.push_back(std::move(fnTask));
+	}
+	m_xCondition.notify_one();
+}
+
+
+/**
+ * @return number of worker threads
+ */
+std::size_t ThreadPool::size() const
+{
+	return m_vecThreads.size();
+}
+
+
+/**
+ * @return a sensible number of worker threads for background work, leaving one core to the render thread
+ */
+std::size_t ThreadPool::defaultThreadCount()
+{
+	const std::size_t uiCores = std::thread::hardware_concurrency();
+	return uiCores > 1 ? uiCores - 1 : 1;
+}
+
+
+/**
+ * Splits defaultThreadCount between several pools running at the same time. Lower pool indices receive the remainder.
+ *
+ * @param uiPool   Index of the pool, in [0, uiPools)
+ * @param uiPools  Number of pools sharing the cores
+ * @return number of worker threads of the pool, at least one
+ */
+std::size_t ThreadPool::defaultThreadCount(const std::size_t uiPool, const std::size_t uiPools)
+{
+	const std::size_t uiThreads = defaultThreadCount();
+	const std::size_t uiShare = uiThreads / uiPools + (uiPool < uiThreads % uiPools ? 1 : 0);
+	return std::max<std::size_t>(uiShare, 1);
+}
+
+
+/**
+ * Main loop of the worker threads
+ */
+void ThreadPool::work()
+{
+	for (;;)
+	{
+		std::function<void()> fnTask;
+		{
+			std::unique_lock<std::mutex> xLock(m_xMutex);
+			m_xCondition.wait(xLock, [this] { return m_bStop || !m_deqTasks.empty(); });
+			if (m_bStop)
+			{
+				return;
+			}
+			fnTask = std::move(m_deqTasks.front());
+			m_deqTasks.pop_front();
+		}
+		fnTask();
+	}
+}
@@ -0,0 +1,310 @@
+#include "voxel/ChunkMesher.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * Faces of a standard cube mesh, in the order top, bottom, right, left, front, back.
+ */
+const std::array<ChunkMesher::CubeFace, 6> ChunkMesher::k_arrCubeFaces = {{
+    // top
+    {glm::ivec3(0, 1, 0),
+     {{glm::ivec3(0, 1, -1), glm::ivec3(0, 1, 0), glm::ivec3(1, 1, 0), glm::ivec3(1, 1, -1)}}},
+    // bottom
+    {glm::ivec3(0, -1, 0),
+     {{glm::ivec3(1, 0, -1), glm::ivec3(1, 0, 0), glm::ivec3(0, 0, 0), glm::ivec3(0, 0, -1)}}},
+    // right
+    {glm::ivec3(1, 0, 0),
+     {{glm::ivec3(1, 1, -1), glm::ivec3(1, 1, 0), glm::ivec3(1, 0, 0), glm::ivec3(1, 0, -1)}}},
+    // left
+    {glm::ivec3(-1, 0, 0),
+     {{glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 0), glm::ivec3(0, 1, 0), glm::ivec3(0, 1, -1)}}},
+    // front
+    {glm::ivec3(0, 0, 1),
+     {{glm::ivec3(0, 1, 0), glm::ivec3(0, 0, 0), glm::ivec3(1, 0, 0), glm::ivec3(1, 1, 0)}}},
+    // back
+    {glm::ivec3(0, 0, -1),
+     {{glm::ivec3(0, 0, -1), glm::ivec3(0, 1, -1), glm::ivec3(1, 1, -1), glm::ivec3(1, 0, -1)}}},
+}};
+
+/**
+ * Appends the four corners of a (possibly merged) face to the vertex list.
+ *
+ * The face spans `extent` voxels along each axis, starting at the voxel `origin`; the extent along the face normal is
+ * 1, or the cell size for downsampled chunks. mesh.vert derives the texture coordinates from the position, face and tile so that the texture is
+ * repeated once per voxel.
+ */
+static void emitFace(std::vector<PackedVertex>& vertices, const ChunkMesher::CubeFace& face, const int faceIndex,
+                     const glm::ivec3& origin, const glm::ivec3& extent, const char block) {
+    // lowest corner of the unit cube, voxels occupy [z - 1, z] along the z axis
+    const auto minCorner = glm::ivec3(0, 0, -1);
+    const auto stretch = extent - glm::ivec3(1);
+
+    for (const auto& corner : face.arrCorners) {
+        vertices.push_back(PackedVertex(origin + corner + stretch * (corner - minCorner), faceIndex, block - 1));
+    }
+}
+
+/**
+ * Emits one quad per exposed voxel face.
+ *
+ * @return the number of exposed faces
+ */
+static std::uint64_t meshNaive(std::vector<PackedVertex>& vertices, const MeshingContext& context,
+                               const std::array<ChunkMesher::CubeFace, 6>& faces) {
+    // offset from the index of a voxel to the index of its neighbour, per face
+    int neighbourOffsets[6];
+    for (std::size_t f = 0; f < faces.size(); f++) {
+        const auto& normal = faces[f].xNormal;
+        neighbourOffsets[f] = normal.x * MeshingContext::k_iStrideX + normal.y * MeshingContext::k_iStrideY +
+                              normal.z * MeshingContext::k_iStrideZ;
+    }
+
+    std::uint64_t exposedFaces = 0;
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            for (int y = context.getColumnBegin(x, z); y < context.getColumnEnd(x, z); y++) {
+                if (context.isSectionSkipped(y / SECTION_SIZE)) {
+                    continue;
+                }
+                const int index = MeshingContext::index(x, y, z);
+                const char block = context[index];
+                if (block == BLOCK_AIR) {
+                    continue;
+                }
+
+                for (int f = 0; f < static_cast<int>(faces.size()); f++) {
+                    if (context[index + neighbourOffsets[f]] == BLOCK_AIR) {
+                        emitFace(vertices, faces[static_cast<std::size_t>(f)], f, glm::ivec3(x, y, z), glm::ivec3(1),
+                                 block);
+                        exposedFaces++;
+                    }
+                }
+            }
+        }
+    }
+    return exposedFaces;
+}
+
+/**
+ * Covers the visible faces of a slice greedily with rectangles, growing them first along the v and then along the u
+ * axis, and clears the mask.
+ *
+ * The mask holds the block type of the face of every cell of the slice, or air, in the order u * sizeV + v. `voxel`
+ * holds the position of the slice along the face normal. Cells are `scale` voxels large along each axis.
+ */
+void ChunkMesher::coverMask(std::vector<PackedVertex>& vertices, std::vector<char>& mask, const CubeFace& face,
+                            const int faceIndex, glm::ivec3 voxel, const int u, const int v, const int sizeU,
+                            const int sizeV, const int scale) {
+    for (int a = 0; a < sizeU; a++) {
+        for (int b = 0; b < sizeV;) {
+            const char block = mask[static_cast<std::size_t>(a * sizeV + b)];
+            if (block == BLOCK_AIR) {
+                b++;
+                continue;
+            }
+
+            int width = 1;
+            while (b + width < sizeV && mask[static_cast<std::size_t>(a * sizeV + b + width)] == block) {
+                width++;
+            }
+
+            int height = 1;
+            for (bool canGrow = true; canGrow && a + height < sizeU;) {
+                for (int k = 0; k < width; k++) {
+                    if (mask[static_cast<std::size_t>((a + height) * sizeV + b + k)] != block) {
+                        canGrow = false;
+                        break;
+                    }
+                }
+                if (canGrow) {
+                    height++;
+                }
+            }
+
+            glm::ivec3 extent(scale);
+            extent[u] = height * scale;
+            extent[v] = width * scale;
+            voxel[u] = a;
+            voxel[v] = b;
+            emitFace(vertices, face, faceIndex, voxel * scale, extent, block);
+
+            for (int i = 0; i < height; i++) {
+                for (int k = 0; k < width; k++) {
+                    mask[static_cast<std::size_t>((a + i) * sizeV + b + k)] = BLOCK_AIR;
+                }
+            }
+            b += width;
+        }
+    }
+}
+
+/**
+ * Merges exposed, coplanar faces of the same block type into maximal rectangles.
+ *
+ * Every face direction is processed slice by slice: the visible faces of a slice are collected into a 2D mask of
+ * block types, which is then covered greedily by coverMask.
+ *
+ * @return the number of exposed faces, i.e. the faces the naive mesher would have emitted
+ */
+static std::uint64_t meshGreedy(std::vector<PackedVertex>& vertices, const MeshingContext& context,
+                                const std::array<ChunkMesher::CubeFace, 6>& faces) {
+    const auto dimensions = glm::ivec3(CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE);
+    std::vector<char> mask;
+
+    std::uint64_t exposedFaces = 0;
+    for (int f = 0; f < static_cast<int>(faces.size()); f++) {
+        const auto& face = faces[static_cast<std::size_t>(f)];
+        // d is the axis along the face normal, u and v span the slice
+        const int d = face.xNormal.x != 0 ? 0 : (face.xNormal.y != 0 ? 1 : 2);
+        const int u = (d + 1) % 3;
+        const int v = (d + 2) % 3;
+        const int sizeU = dimensions[u];
+        const int sizeV = dimensions[v];
+        const int neighbourOffset = face.xNormal.x * MeshingContext::k_iStrideX +
+                                    face.xNormal.y * MeshingContext::k_iStrideY +
+                                    face.xNormal.z * MeshingContext::k_iStrideZ;
+        mask.assign(static_cast<std::size_t>(sizeU * sizeV), BLOCK_AIR);
+
+        for (int slice = 0; slice < dimensions[d]; slice++) {
+            if (d == 1 && (slice < context.getMeshedBegin() || slice >= context.getMeshedEnd() ||
+                           context.isSectionSkipped(slice / SECTION_SIZE))) {
+                continue;
+            }
+
+            // collect the visible faces of this slice
+            glm::ivec3 voxel(0);
+            voxel[d] = slice;
+            for (int a = 0; a < sizeU; a++) {
+                for (int b = 0; b < sizeV; b++) {
+                    voxel[u] = a;
+                    voxel[v] = b;
+                    if (voxel.y < context.getColumnBegin(voxel.x, voxel.z) ||
+                        voxel.y >= context.getColumnEnd(voxel.x, voxel.z) ||
+                        context.isSectionSkipped(voxel.y / SECTION_SIZE)) {
+                        continue;
+                    }
+                    const int index = MeshingContext::index(voxel.x, voxel.y, voxel.z);
+                    const char block = context[index];
+                    if (block != BLOCK_AIR && context[index + neighbourOffset] == BLOCK_AIR) {
+                        mask[static_cast<std::size_t>(a * sizeV + b)] = block;
+                        exposedFaces++;
+                    }
+                }
+            }
+
+            ChunkMesher::coverMask(vertices, mask, face, f, voxel, u, v, sizeU, sizeV, 1);
+        }
+    }
+    return exposedFaces;
+}
+
+/**
+ * @return index of the lowest set bit, value must not be 0
+ */
+static int countTrailingZeros(const std::uint64_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+/**
+ * Builds the occupancy mask of a column, bit y is set if the voxel at height y is not air.
+ */
+static std::uint64_t columnMask(const MeshingContext& context, const int x, const int z) {
+    std::uint64_t mask = 0;
+    for (int y = 0; y < CHUNK_HEIGHT; y++) {
+        if (context(x, y, z) != BLOCK_AIR) {
+            mask |= std::uint64_t(1) << y;
+        }
+    }
+    return mask;
+}
+
+/**
+ * Emits one quad per exposed voxel face, like meshNaive, but finds the exposed faces of a whole column at once by
+ * comparing its occupancy mask to the shifted mask (top, bottom) or the masks of the neighbouring columns.
+ *
+ * @return the number of exposed faces
+ */
+static std::uint64_t meshBinary(std::vector<PackedVertex>& vertices, const MeshingContext& context,
+                                const std::array<ChunkMesher::CubeFace, 6>& faces) {
+    static_assert(CHUNK_HEIGHT == 64, "Column masks require exactly 64 voxels per column");
+
+    // occupancy of the columns, including the apron columns of the neighbouring chunks
+    std::uint64_t columns[CHUNK_SIZE + 2][CHUNK_SIZE + 2];
+    for (int x = -1; x <= CHUNK_SIZE; x++) {
+        for (int z = -1; z <= CHUNK_SIZE; z++) {
+            columns[x + 1][z + 1] = columnMask(context, x, z);
+        }
+    }
+
+    // layers of the sections which are not skipped
+    std::uint64_t meshedLayers = 0;
+    for (int section = 0; section < SECTION_COUNT; section++) {
+        if (!context.isSectionSkipped(section)) {
+            meshedLayers |= ((std::uint64_t(1) << SECTION_SIZE) - 1) << (section * SECTION_SIZE);
+        }
+    }
+
+    std::uint64_t exposedFaces = 0;
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            const std::uint64_t column = columns[x + 1][z + 1];
+            if (column == 0) {
+                continue;
+            }
+
+            // layers of the column which can have visible faces
+            const int end = context.getColumnEnd(x, z);
+            const std::uint64_t range = (end == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << end) - 1) &
+                                        ~((std::uint64_t(1) << context.getColumnBegin(x, z)) - 1);
+
+            // visible faces per face direction, in the order of the cube faces. Faces at the top of the chunk are
+            // always visible, faces at the bottom never.
+            const std::uint64_t visible[6] = {
+                column & ~(column >> 1),
+                column & ~(column << 1) & ~std::uint64_t(1),
+                column & ~columns[x + 2][z + 1],
+                column & ~columns[x][z + 1],
+                column & ~columns[x + 1][z + 2],
+                column & ~columns[x + 1][z],
+            };
+
+            for (int f = 0; f < static_cast<int>(faces.size()); f++) {
+                for (std::uint64_t bits = visible[f] & meshedLayers & range; bits != 0; bits &= bits - 1) {
+                    const int y = countTrailingZeros(bits);
+                    emitFace(vertices, faces[static_cast<std::size_t>(f)], f, glm::ivec3(x, y, z), glm::ivec3(1),
+                             context(x, y, z));
+                    exposedFaces++;
+                }
+            }
+        }
+    }
+    return exposedFaces;
+}
+
+/**
+ * Meshes a chunk with the given strategy.
+ *
+ * @return the number of exposed faces
+ */
+std::uint64_t ChunkMesher::meshChunk(std::vector<PackedVertex>& vertices, const MeshingContext& context,
+                                     const MeshingMode mode) {
+    switch (mode) {
+    case MeshingMode::eNaive:
+        return meshNaive(vertices, context, k_arrCubeFaces);
+    case MeshingMode::eGreedy:
+        return meshGreedy(vertices, context, k_arrCubeFaces);
+    case MeshingMode::eBinary:
+        return meshBinary(vertices, context, k_arrCubeFaces);
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "voxel/MeshingContext.h"
+
+#include <algorithm>
+
+
+/**
+ * Any block which is not air, used for the apron below the chunk
+ */
+static const char k_cSolidBorder = 1;
+
+
+/**
+ * @return whether the section of the chunk consists of a single solid block type
+ */
+static bool isSolidSection(const Chunk& xChunk, const int iSection)
+{
+	return xChunk.isSectionUniform(iSection) && xChunk.uniformValue(iSection) != BLOCK_AIR;
+}
+
+
+/**
+ * Builds the padded volume for a chunk
+ *
+ * @param xChunk  Voxels of the chunk
+ * @param xLeft   Neighbouring chunk towards -x
+ * @param xRight  Neighbouring chunk towards +x
+ * @param xBack   Neighbouring chunk towards -z
+ * @param xFront  Neighbouring chunk towards +z
+ */
+MeshingContext::MeshingContext(const Chunk& xChunk, const Chunk& xLeft, const Chunk& xRight, const Chunk& xBack, const Chunk& xFront)
+{
+	std::fill(std::begin(m_arrVoxels), std::end(m_arrVoxels), static_cast<char>(BLOCK_AIR));
+
+	for (int iX = -1; iX <= CHUNK_SIZE; ++iX)
+	{
+		for (int iZ = -1; iZ <= CHUNK_SIZE; ++iZ)
+		{
+			m_arrVoxels[static_cast<std::size_t>(index(iX, -1, iZ))] = k_cSolidBorder;
+		}
+	}
+
+	for (int iY = 0; iY < CHUNK_HEIGHT; ++iY)
+	{
+		for (int iI = 0; iI < CHUNK_SIZE; ++iI)
+		{
+			m_arrVoxels[static_cast<std::size_t>(index(-1, iY, iI))] = xLeft(CHUNK_SIZE - 1, iY, iI);
+			m_arrVoxels[static_cast<std::size_t>(index(CHUNK_SIZE, iY, iI))] = xRight(0, iY, iI);
+			m_arrVoxels[static_cast<std::size_t>(index(iI, iY, -1))] = xBack(iI, iY, CHUNK_SIZE - 1);
+			m_arrVoxels[static_cast<std::size_t>(index(iI, iY, CHUNK_SIZE))] = xFront(iI, iY, 0);
+		}
+	}
+
+	// Rows along z are contiguous in the padded volume as well, so they are decoded in place. The rows above the
+	// highest solid voxel are air already.
+	for (int iX = 0; iX < CHUNK_SIZE; ++iX)
+	{
+		for (int iY = 0; iY < xChunk.getMaxTop(); ++iY)
+		{
+			xChunk.decodeRow(iX, iY, &m_arrVoxels[static_cast<std::size_t>(index(iX, iY, 0))]);
+		}
+	}
+
+	// A voxel can only have a visible face at or above the floor of a neighbouring column, or at the top of the floor
+	// of its own column
+	m_iMeshedBegin = CHUNK_HEIGHT;
+	m_iMeshedEnd = 0;
+	for (int iX = 0; iX < CHUNK_SIZE; ++iX)
+	{
+		for (int iZ = 0; iZ < CHUNK_SIZE; ++iZ)
+		{
+			const int iLeft = iX > 0 ? xChunk.columnFloor(iX - 1, iZ) : xLeft.columnFloor(CHUNK_SIZE - 1, iZ);
+			const int iRight = iX + 1 < CHUNK_SIZE ? xChunk.columnFloor(iX + 1, iZ) : xRight.columnFloor(0, iZ);
+			const int iBack = iZ > 0 ? xChunk.columnFloor(iX, iZ - 1) : xBack.columnFloor(iX, CHUNK_SIZE - 1);
+			const int iFront = iZ + 1 < CHUNK_SIZE ? xChunk.columnFloor(iX, iZ + 1) : xFront.columnFloor(iX, 0);
+			const int iBegin = std::max(0, std::min({xChunk.columnFloor(iX, iZ) - 1, iLeft, iRight, iBack, iFront}));
+			const int iEnd = xChunk.columnTop(iX, iZ);
+
+			m_arrColumnBegin[iX][iZ] = static_cast<std::uint8_t>(iBegin);
+			m_arrColumnEnd[iX][iZ] = static_cast<std::uint8_t>(iEnd);
+			if (iBegin < iEnd)
+			{
+				m_iMeshedBegin = std::min(m_iMeshedBegin, iBegin);
+				m_iMeshedEnd = std::max(m_iMeshedEnd, iEnd);
+			}
+		}
+	}
+	m_iMeshedEnd = std::max(m_iMeshedEnd, m_iMeshedBegin);
+
+	for (int iSection = 0; iSection < SECTION_COUNT; ++iSection)
+	{
+		const bool bEmpty = xChunk.isSectionUniform(iSection) && xChunk.uniformValue(iSection) == BLOCK_AIR;
+		// The apron below the chunk is solid, the one above is air
+		const bool bBuried = isSolidSection(xChunk, iSection) &&
+			(iSection == 0 || isSolidSection(xChunk, iSection - 1)) &&
+			(iSection + 1 < SECTION_COUNT && isSolidSection(xChunk, iSection + 1)) &&
+			isSolidSection(xLeft, iSection) && isSolidSection(xRight, iSection) &&
+			isSolidSection(xBack, iSection) && isSolidSection(xFront, iSection);
+		m_arrSkippedSections[iSection] = bEmpty || bBuried;
+	}
+}
+
+
+/**
+ * @return number of sections the meshers can skip
+ */
+int MeshingContext::getSkippedSectionCount() const
+{
+	return static_cast<int>(std::count(std::begin(m_arrSkippedSections), std::end(m_arrSkippedSections), true));
+}
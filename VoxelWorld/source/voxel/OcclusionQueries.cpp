@@ -0,0 +1,199 @@
+#include "voxel/OcclusionQueries.h"
+
+#include <cstring>
+
+
+/**
+ * Loads the shader and creates the buffers
+ */
+OcclusionQueries::OcclusionQueries()
+	: m_uiVertexArrayObject(0), m_xStreamBuffer(k_xStreamBufferSize), m_xStorageAlignment(0), m_uiFrame(0)
+{
+	Shader xVertexShader = Shader::loadFromFile("occlusion_box.vert", Shader::Type::Vertex);
+	Shader xFragmentShader = Shader::loadFromFile("occlusion_box.frag", Shader::Type::Fragment);
+	m_xShaderProgram.attachShader(xVertexShader);
+	m_xShaderProgram.attachShader(xFragmentShader);
+	m_xShaderProgram.link();
+
+	GLint iStorageAlignment = 0;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &iStorageAlignment);
+	m_xStorageAlignment = static_cast<voxel::RingBuffer::size_type>(iStorageAlignment);
+
+	glGenVertexArrays(1, &m_uiVertexArrayObject);
+}
+
+
+/**
+ * Destructor, frees the query objects.
+ * The stream buffer frees itself.
+ */
+OcclusionQueries::~OcclusionQueries()
+{
+	for (const auto& xEntry : m_mapQueries)
+	{
+		glDeleteQueries(1, &xEntry.second.uiQuery);
+	}
+	if (!m_vecFreeQueries.empty())
+	{
+		glDeleteQueries(static_cast<GLsizei>(m_vecFreeQueries.size()), m_vecFreeQueries.data());
+	}
+	glDeleteVertexArrays(1, &m_uiVertexArrayObject);
+}
+
+
+/**
+ * Reads the result of the query of a chunk if the GPU has it ready, without waiting for it. Must be called before
+ * the chunk is queued in the current frame.
+ *
+ * @param xPosition  Position of the chunk
+ * @return whether the latest available result found the chunk hidden, false if there is none or the chunk was not
+ *         queued in the previous frame
+ */
+bool OcclusionQueries::isOccluded(const glm::ivec3& xPosition)
+{
+	const auto it = m_mapQueries.find(xPosition);
+	if (it == m_mapQueries.end())
+	{
+		return false;
+	}
+
+	Query& xQuery = it->second;
+	if (xQuery.bPending)
+	{
+		GLuint uiAvailable = GL_FALSE;
+		glGetQueryObjectuiv(xQuery.uiQuery, GL_QUERY_RESULT_AVAILABLE, &uiAvailable);
+		if (uiAvailable == GL_TRUE)
+		{
+			GLuint uiSamplesPassed = GL_FALSE;
+			glGetQueryObjectuiv(xQuery.uiQuery, GL_QUERY_RESULT, &uiSamplesPassed);
+			xQuery.bOccluded = !xQuery.bStale && uiSamplesPassed == GL_FALSE;
+			xQuery.bPending = false;
+			xQuery.bStale = false;
+			m_xStatistics.uiResults++;
+		}
+	}
+	// The result of a chunk which was outside the frustum describes an old view
+	return xQuery.bOccluded && xQuery.uiLastFrame + 1 >= m_uiFrame;
+}
+
+
+/**
+ * Queues the box of a chunk to be queried by the next call of issueQueued.
+ * A chunk whose previous query has no result yet is not queried again, as the query object is still in use. If the
+ * chunk was not queued in the previous frame its result is dropped, including the one of a query still pending.
+ *
+ * @param xPosition  Position of the chunk
+ * @param xMin       Minimum corner of the box in world coordinates
+ * @param xMax       Maximum corner of the box in world coordinates
+ */
+void OcclusionQueries::queue(const glm::ivec3& xPosition, const glm::vec3& xMin, const glm::vec3& xMax)
+{
+	auto it = m_mapQueries.find(xPosition);
+	if (it == m_mapQueries.end())
+	{
+		Query xQuery;
+		if (m_vecFreeQueries.empty())
+		{
+			glGenQueries(1, &xQuery.uiQuery);
+		}
+		else
+		{
+			xQuery.uiQuery = m_vecFreeQueries.back();
+			m_vecFreeQueries.pop_back();
+		}
+		xQuery.bPending = false;
+		xQuery.bOccluded = false;
+		xQuery.bStale = false;
+		it = m_mapQueries.emplace(xPosition, xQuery).first;
+	}
+	else if (it->second.uiLastFrame + 1 < m_uiFrame)
+	{
+		it->second.bOccluded = false;
+		it->second.bStale = it->second.bPending;
+	}
+
+	it->second.uiLastFrame = m_uiFrame;
+	if (it->second.bPending)
+	{
+		return;
+	}
+
+	Box xBox;
+	xBox.xMin = glm::vec4(xMin, 1.0f);
+	xBox.xMax = glm::vec4(xMax, 1.0f);
+	m_vecQueued.push_back(xPosition);
+	m_vecBoxes.push_back(xBox);
+}
+
+
+/**
+ * Draws the queued boxes with one query each, clears the queue and recycles the queries of chunks which have not
+ * been queued for a while.
+ * Both sides of the boxes are drawn, so a box still counts as visible if the near plane cuts off its front faces. Color
+ * and depth writes are disabled while the boxes are drawn and restored afterwards.
+ *
+ * @param xViewProjection  Matrix transforming world coordinates into clip space
+ */
+void OcclusionQueries::issueQueued(const glm::mat4& xViewProjection)
+{
+	const auto xBoxBytes = static_cast<voxel::RingBuffer::size_type>(sizeof(Box) * m_vecBoxes.size());
+	voxel::RingBuffer::size_type xStreamOffset = 0;
+	void* const pStreamMemory = m_vecBoxes.empty() ? nullptr : m_xStreamBuffer.allocate(xBoxBytes, m_xStorageAlignment, xStreamOffset);
+	if (pStreamMemory != nullptr)
+	{
+		memcpy(pStreamMemory, m_vecBoxes.data(), xBoxBytes);
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, m_xStreamBuffer.handle(), xStreamOffset, xBoxBytes);
+
+		m_xShaderProgram.use();
+		m_xShaderProgram.setUniform("vp", xViewProjection);
+		glBindVertexArray(m_uiVertexArrayObject);
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glDepthMask(GL_FALSE);
+		glDisable(GL_CULL_FACE);
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+		for (std::size_t uiBox = 0; uiBox < m_vecQueued.size(); ++uiBox)
+		{
+			Query& xQuery = m_mapQueries[m_vecQueued[uiBox]];
+			glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, xQuery.uiQuery);
+			glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 14, 1, static_cast<GLuint>(uiBox));
+			glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+			xQuery.bPending = true;
+		}
+		m_xStatistics.uiIssued = m_vecQueued.size();
+
+		glEnable(GL_CULL_FACE);
+		glDepthMask(GL_TRUE);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		m_xStreamBuffer.fence();
+	}
+	m_vecQueued.clear();
+	m_vecBoxes.clear();
+
+	// A pending query is still recycled, its result is never read
+	for (auto it = m_mapQueries.begin(); it != m_mapQueries.end();)
+	{
+		if (m_uiFrame - it->second.uiLastFrame > k_uiMaxIdleFrames)
+		{
+			m_vecFreeQueries.push_back(it->second.uiQuery);
+			it = m_mapQueries.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	m_xLastStatistics = m_xStatistics;
+	m_xStatistics = Statistics();
+	m_uiFrame++;
+}
+
+
+/**
+ * @return query counts of the last frame
+ */
+const OcclusionQueries::Statistics& OcclusionQueries::getStatistics() const
+{
+	return m_xLastStatistics;
+}
@@ -0,0 +1,614 @@
+#include "voxel/RegionStore.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <direct.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+
+/** First bytes of every region file */
+const char k_arrMagic[4] = { 'V', 'X', 'R', 'G' };
+
+/** Version of the region file format, files of other versions are replaced */
+const std::uint32_t k_uiVersion = 1;
+
+/** Offset [bytes] of the table within a region file, after the magic and the version */
+const std::size_t k_uiTableOffset = 8;
+
+/** Size [bytes] of a table entry, the offset and the size of a chunk */
+const std::size_t k_uiEntryBytes = 8;
+
+/** Size [bytes] of the header of a region file */
+const std::size_t k_uiHeaderBytes = k_uiTableOffset + k_uiEntryBytes * RegionStore::k_iRegionSize * RegionStore::k_iRegionSize;
+
+/** Number of voxels of a chunk */
+const std::size_t k_uiChunkVoxels = CHUNK_SIZE * CHUNK_HEIGHT * CHUNK_SIZE;
+
+/**
+ * @param p  Four bytes
+ * @return the little endian integer stored in the bytes
+ */
+std::uint32_t readUint32(const std::uint8_t* p)
+{
+	return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 | static_cast<std::uint32_t>(p[2]) << 16 |
+		static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+/**
+ * @param p       Four bytes receiving the integer
+ * @param uValue  Integer to store little endian
+ */
+void writeUint32(std::uint8_t* p, const std::uint32_t uValue)
+{
+	for (int i = 0; i < 4; ++i)
+	{
+		p[i] = static_cast<std::uint8_t>(uValue >> (8 * i));
+	}
+}
+
+/**
+ * @param pHeader  First eight bytes of a region file
+ * @return whether they hold the magic and the current version
+ */
+bool isValidHeader(const std::uint8_t* pHeader)
+{
+	return memcmp(pHeader, k_arrMagic, sizeof(k_arrMagic)) == 0 && readUint32(pHeader + 4) == k_uiVersion;
+}
+
+/**
+ * @return a divided by b, rounded towards negative infinity
+ */
+int floorDiv(const int a, const int b)
+{
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+/**
+ * Creates a directory, nothing happens if it exists already
+ *
+ * @param strPath  Path of the directory
+ */
+void createDirectory(const std::string& strPath)
+{
+#if defined(_WIN32)
+	_mkdir(strPath.c_str());
+#else
+	mkdir(strPath.c_str(), 0755);
+#endif
+}
+
+}
+
+
+/**
+ * Read-only memory mapping of a whole region file. The mapping is shared, so it sees what the writer appends to the
+ * file within the mapped size, i.e. the table.
+ */
+class RegionStore::MappedFile final
+{
+private:
+	/**
+	 * First byte of the mapping, nullptr if the file could not be mapped
+	 */
+	const std::uint8_t* m_pData;
+
+	/**
+	 * Size [bytes] of the mapping, the size of the file when it was mapped
+	 */
+	std::size_t m_uiSize;
+
+#if defined(_WIN32)
+	/**
+	 * Handles to the file and its mapping object
+	 */
+	HANDLE m_hFile;
+	HANDLE m_hMapping;
+#endif
+
+public:
+	/**
+	 * Maps a file, the mapping is empty if the file does not exist or is empty
+	 *
+	 * @param strPath  Path of the file
+	 */
+	explicit MappedFile(const std::string& strPath);
+
+	/**
+	 * Destructor, unmaps the file
+	 */
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/**
+	 * @return first byte of the mapping
+	 */
+	const std::uint8_t* data() const
+	{
+		return m_pData;
+	}
+
+	/**
+	 * @return size [bytes] of the mapping, zero if the file could not be mapped
+	 */
+	std::size_t size() const
+	{
+		return m_uiSize;
+	}
+};
+
+
+#if defined(_WIN32)
+
+RegionStore::MappedFile::MappedFile(const std::string& strPath)
+	: m_pData(nullptr), m_uiSize(0), m_hFile(INVALID_HANDLE_VALUE), m_hMapping(nullptr)
+{
+	// the writer keeps the file open for writing at the same time
+	m_hFile = CreateFileA(strPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER xSize;
+	if (m_hFile == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_hFile, &xSize) || xSize.QuadPart == 0)
+	{
+		return;
+	}
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_hMapping == nullptr)
+	{
+		return;
+	}
+	m_pData = static_cast<const std::uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	m_uiSize = m_pData == nullptr ? 0 : static_cast<std::size_t>(xSize.QuadPart);
+}
+
+
+RegionStore::MappedFile::~MappedFile()
+{
+	if (m_pData != nullptr)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (m_hMapping != nullptr)
+	{
+		CloseHandle(m_hMapping);
+	}
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+	}
+}
+
+#else
+
+RegionStore::MappedFile::MappedFile(const std::string& strPath)
+	: m_pData(nullptr), m_uiSize(0)
+{
+	const int iFile = open(strPath.c_str(), O_RDONLY);
+	if (iFile < 0)
+	{
+		return;
+	}
+	struct stat xStat;
+	if (fstat(iFile, &xStat) == 0 && xStat.st_size > 0)
+	{
+		const auto uiSize = static_cast<std::size_t>(xStat.st_size);
+		void* const pMapping = mmap(nullptr, uiSize, PROT_READ, MAP_SHARED, iFile, 0);
+		if (pMapping != MAP_FAILED)
+		{
+			m_pData = static_cast<const std::uint8_t*>(pMapping);
+			m_uiSize = uiSize;
+		}
+	}
+	// the mapping stays valid without the descriptor
+	close(iFile);
+}
+
+
+RegionStore::MappedFile::~MappedFile()
+{
+	if (m_pData != nullptr)
+	{
+		munmap(const_cast<std::uint8_t*>(m_pData), m_uiSize);
+	}
+}
+
+#endif
+
+
+/**
+ * Starts the writer, creating the directory when the first chunk is written
+ *
+ * @param strDirectory  Directory holding the region files
+ */
+RegionStore::RegionStore(const std::string& strDirectory)
+	: k_strDirectory(strDirectory), m_bStop(false), m_xWriter(&RegionStore::writeQueued, this)
+{
+}
+
+
+/**
+ * Destructor
+ * Writes the queued chunks and stops the writer. The files and mappings are closed with their members.
+ */
+RegionStore::~RegionStore()
+{
+	{
+		std::lock_guard<std::mutex> xLock(m_xWriteMutex);
+		m_bStop = true;
+	}
+	m_xWriteCondition.notify_all();
+	m_xWriter.join();
+}
+
+
+/**
+ * Reads a chunk from its region file through a mapping of the file
+ *
+ * @param xPosition  Position of the chunk
+ * @return the chunk, an empty pointer if it has not been stored or its data is damaged
+ */
+std::shared_ptr<Chunk> RegionStore::load(const glm::ivec3& xPosition)
+{
+	const auto xStart = std::chrono::steady_clock::now();
+
+	const glm::ivec2 xRegion = regionOf(xPosition);
+	std::shared_ptr<const MappedFile> pMapping = mapRegion(xRegion, k_uiHeaderBytes);
+	if (!pMapping)
+	{
+		return std::shared_ptr<Chunk>();
+	}
+
+	const std::uint8_t* const pEntry = pMapping->data() + k_uiTableOffset + k_uiEntryBytes * tableIndex(xPosition);
+	const std::size_t uiOffset = readUint32(pEntry);
+	const std::size_t uiSize = readUint32(pEntry + 4);
+	if (uiOffset == 0)
+	{
+		return std::shared_ptr<Chunk>();
+	}
+	if (uiOffset + uiSize > pMapping->size())
+	{
+		// appended after the file was mapped
+		pMapping = mapRegion(xRegion, uiOffset + uiSize);
+		if (!pMapping)
+		{
+			return std::shared_ptr<Chunk>();
+		}
+	}
+
+	std::shared_ptr<Chunk> pChunk = decode(pMapping->data() + uiOffset, uiSize);
+	if (pChunk)
+	{
+		const std::chrono::duration<double> xLoadTime = std::chrono::steady_clock::now() - xStart;
+		std::lock_guard<std::mutex> xLock(m_xWriteMutex);
+		m_xStatistics.uiLoadedChunks++;
+		m_xStatistics.dLoadTime += xLoadTime.count();
+	}
+	return pChunk;
+}
+
+
+/**
+ * Encodes a chunk on the calling thread and queues it to be written to its region file on the writer thread
+ *
+ * @param xPosition  Position of the chunk
+ * @param xChunk     Chunk to store
+ */
+void RegionStore::save(const glm::ivec3& xPosition, const Chunk& xChunk)
+{
+	Write xWrite;
+	xWrite.xPosition = xPosition;
+	xWrite.vecData = encode(xChunk);
+	{
+		std::lock_guard<std::mutex> xLock(m_xWriteMutex);
+		m_deqWrites.push_back(std::move(xWrite));
+		m_xStatistics.uiQueuedWrites = m_deqWrites.size();
+	}
+	m_xWriteCondition.notify_one();
+}
+
+
+/**
+ * @return counts of the loaded and saved chunks
+ */
+RegionStore::Statistics RegionStore::getStatistics() const
+{
+	std::lock_guard<std::mutex> xLock(m_xWriteMutex);
+	return m_xStatistics;
+}
+
+
+/**
+ * Encodes the voxels of a chunk as runs along its columns, in the order x, z, y. The solid part and the air of a
+ * column are a few runs each, a run is at most 255 voxels long.
+ *
+ * @param xChunk  Chunk to encode
+ * @return runs of the chunk, two bytes per run: the length and the voxel
+ */
+std::vector<std::uint8_t> RegionStore::encode(const Chunk& xChunk)
+{
+	// the layers above the highest column are air
+	std::vector<char> vecVoxels(k_uiChunkVoxels, BLOCK_AIR);
+	char arrRow[CHUNK_SIZE];
+	for (int iX = 0; iX < CHUNK_SIZE; ++iX)
+	{
+		for (int iY = 0; iY < xChunk.getMaxTop(); ++iY)
+		{
+			xChunk.decodeRow(iX, iY, arrRow);
+			for (int iZ = 0; iZ < CHUNK_SIZE; ++iZ)
+			{
+				vecVoxels[static_cast<std::size_t>((iX * CHUNK_SIZE + iZ) * CHUNK_HEIGHT + iY)] = arrRow[iZ];
+			}
+		}
+	}
+
+	std::vector<std::uint8_t> vecRuns;
+	for (std::size_t uiStart = 0; uiStart < vecVoxels.size();)
+	{
+		std::size_t uiEnd = uiStart + 1;
+		while (uiEnd < vecVoxels.size() && uiEnd - uiStart < 255 && vecVoxels[uiEnd] == vecVoxels[uiStart])
+		{
+			++uiEnd;
+		}
+		vecRuns.push_back(static_cast<std::uint8_t>(uiEnd - uiStart));
+		vecRuns.push_back(static_cast<std::uint8_t>(vecVoxels[uiStart]));
+		uiStart = uiEnd;
+	}
+	return vecRuns;
+}
+
+
+/**
+ * Decodes a chunk encoded by encode
+ *
+ * @param pData   Runs of the chunk
+ * @param uiSize  Number of bytes of the runs
+ * @return the chunk, an empty pointer if the runs do not cover the chunk exactly
+ */
+std::shared_ptr<Chunk> RegionStore::decode(const std::uint8_t* pData, const std::size_t uiSize)
+{
+	if (uiSize % 2 != 0)
+	{
+		return std::shared_ptr<Chunk>();
+	}
+
+	// value initialization fills the chunk with air
+	std::unique_ptr<DenseChunk> pDense(new DenseChunk());
+	std::size_t uiVoxel = 0;
+	int iTop = 0;
+	for (std::size_t uiRun = 0; uiRun < uiSize; uiRun += 2)
+	{
+		const std::size_t uiLength = pData[uiRun];
+		const auto cValue = static_cast<char>(pData[uiRun + 1]);
+		if (uiLength == 0 || uiVoxel + uiLength > k_uiChunkVoxels)
+		{
+			return std::shared_ptr<Chunk>();
+		}
+		if (cValue == BLOCK_AIR)
+		{
+			uiVoxel += uiLength;
+			continue;
+		}
+		for (const std::size_t uiEnd = uiVoxel + uiLength; uiVoxel < uiEnd; ++uiVoxel)
+		{
+			const auto iX = static_cast<int>(uiVoxel / (CHUNK_SIZE * CHUNK_HEIGHT));
+			const auto iZ = static_cast<int>(uiVoxel / CHUNK_HEIGHT % CHUNK_SIZE);
+			const auto iY = static_cast<int>(uiVoxel % CHUNK_HEIGHT);
+			(*pDense)(iX, iY, iZ) = cValue;
+			iTop = std::max(iTop, iY + 1);
+		}
+	}
+	if (uiVoxel != k_uiChunkVoxels)
+	{
+		return std::shared_ptr<Chunk>();
+	}
+
+	// the sections above the highest voxel stay air without being compressed, as for generated chunks
+	return std::make_shared<Chunk>(*pDense, (iTop + SECTION_SIZE - 1) / SECTION_SIZE);
+}
+
+
+/**
+ * @param xPosition  Position of a chunk
+ * @return position of the region holding the chunk
+ */
+glm::ivec2 RegionStore::regionOf(const glm::ivec3& xPosition)
+{
+	return glm::ivec2(floorDiv(xPosition.x, k_iRegionSize), floorDiv(xPosition.z, k_iRegionSize));
+}
+
+
+/**
+ * @param xPosition  Position of a chunk
+ * @return index of the chunk in the table of its region file, in the order x * k_iRegionSize + z within the region
+ */
+std::size_t RegionStore::tableIndex(const glm::ivec3& xPosition)
+{
+	const glm::ivec2 xRegion = regionOf(xPosition);
+	const int iX = xPosition.x - xRegion.x * k_iRegionSize;
+	const int iZ = xPosition.z - xRegion.y * k_iRegionSize;
+	return static_cast<std::size_t>(iX * k_iRegionSize + iZ);
+}
+
+
+/**
+ * @param xRegion  Position of a region
+ * @return path of the region file
+ */
+std::string RegionStore::regionPath(const glm::ivec2& xRegion) const
+{
+	return k_strDirectory + "/r." + std::to_string(xRegion.x) + "." + std::to_string(xRegion.y) + ".vxr";
+}
+
+
+/**
+ * Returns a mapping of a region file which covers the given number of bytes, mapping the file again if the current
+ * mapping is shorter. Only mappings of files with a valid header are kept.
+ *
+ * @param xRegion  Position of the region
+ * @param uiBytes  Number of bytes from the start of the file the mapping must cover, at least the header
+ * @return the mapping, an empty pointer if the file does not exist or is shorter
+ */
+std::shared_ptr<const RegionStore::MappedFile> RegionStore::mapRegion(const glm::ivec2& xRegion, const std::size_t uiBytes)
+{
+	std::lock_guard<std::mutex> xLock(m_xMappingMutex);
+	const auto it = m_mapMappings.find(xRegion);
+	if (it != m_mapMappings.end() && it->second->size() >= uiBytes)
+	{
+		return it->second;
+	}
+
+	const auto pMapping = std::make_shared<const MappedFile>(regionPath(xRegion));
+	if (pMapping->size() < uiBytes || pMapping->size() < k_uiHeaderBytes || !isValidHeader(pMapping->data()))
+	{
+		return std::shared_ptr<const MappedFile>();
+	}
+	m_mapMappings[xRegion] = pMapping;
+	return pMapping;
+}
+
+
+/**
+ * Main loop of the writer thread, writes the queued chunks one after the other until the store is destroyed and the
+ * queue is empty
+ */
+void RegionStore::writeQueued()
+{
+	for (;;)
+	{
+		Write xWrite;
+		{
+			std::unique_lock<std::mutex> xLock(m_xWriteMutex);
+			m_xWriteCondition.wait(xLock, [this] { return m_bStop || !m_deqWrites.empty(); });
+			if (m_deqWrites.empty())
+			{
+				return;
+			}
+			xWrite = std::move(m_deqWrites.front());
+			m_deqWrites.pop_front();
+		}
+
+		const bool bWritten = writeChunk(xWrite);
+
+		std::lock_guard<std::mutex> xLock(m_xWriteMutex);
+		if (bWritten)
+		{
+			m_xStatistics.uiSavedChunks++;
+			m_xStatistics.uiSavedBytes += xWrite.vecData.size();
+		}
+		else
+		{
+			m_xStatistics.uiFailedWrites++;
+		}
+		m_xStatistics.uiQueuedWrites = m_deqWrites.size();
+	}
+}
+
+
+/**
+ * Appends a chunk to its region file and points the table to it. The data is flushed before the table is updated,
+ * so a reader finding the entry also finds the data.
+ *
+ * @param xWrite  Chunk to write
+ * @return whether the chunk was written
+ */
+bool RegionStore::writeChunk(const Write& xWrite)
+{
+	std::fstream* const pFile = openRegion(regionOf(xWrite.xPosition));
+	if (pFile == nullptr)
+	{
+		return false;
+	}
+
+	pFile->seekp(0, std::ios::end);
+	const std::streamoff iOffset = pFile->tellp();
+	if (iOffset < static_cast<std::streamoff>(k_uiHeaderBytes) ||
+		iOffset + static_cast<std::streamoff>(xWrite.vecData.size()) > static_cast<std::streamoff>(UINT32_MAX))
+	{
+		return false;
+	}
+	pFile->write(reinterpret_cast<const char*>(xWrite.vecData.data()), static_cast<std::streamsize>(xWrite.vecData.size()));
+	pFile->flush();
+
+	std::uint8_t arrEntry[k_uiEntryBytes];
+	writeUint32(arrEntry, static_cast<std::uint32_t>(iOffset));
+	writeUint32(arrEntry + 4, static_cast<std::uint32_t>(xWrite.vecData.size()));
+	pFile->seekp(static_cast<std::streamoff>(k_uiTableOffset + k_uiEntryBytes * tableIndex(xWrite.xPosition)), std::ios::beg);
+	pFile->write(reinterpret_cast<const char*>(arrEntry), static_cast<std::streamsize>(k_uiEntryBytes));
+	pFile->flush();
+
+	if (!pFile->good())
+	{
+		// the file is opened again for the next chunk of the region
+		m_mapFiles.erase(regionOf(xWrite.xPosition));
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * Opens a region file for writing, creating it with an empty table or recreating it if its header is invalid, e.g.
+ * as it was written by another version
+ *
+ * @param xRegion  Position of the region
+ * @return the open file, nullptr if it cannot be opened
+ */
+std::fstream* RegionStore::openRegion(const glm::ivec2& xRegion)
+{
+	const auto it = m_mapFiles.find(xRegion);
+	if (it != m_mapFiles.end())
+	{
+		return it->second.get();
+	}
+
+	createDirectory(k_strDirectory);
+	const std::string strPath = regionPath(xRegion);
+	std::unique_ptr<std::fstream> pFile(new std::fstream(strPath, std::ios::in | std::ios::out | std::ios::binary));
+
+	bool bValid = false;
+	if (pFile->is_open())
+	{
+		std::uint8_t arrHeader[k_uiTableOffset];
+		pFile->read(reinterpret_cast<char*>(arrHeader), static_cast<std::streamsize>(k_uiTableOffset));
+		bValid = pFile->gcount() == static_cast<std::streamsize>(k_uiTableOffset) && isValidHeader(arrHeader);
+		pFile->clear();
+		pFile->seekg(0, std::ios::end);
+		bValid = bValid && static_cast<std::streamoff>(pFile->tellg()) >= static_cast<std::streamoff>(k_uiHeaderBytes);
+	}
+
+	if (!bValid)
+	{
+		pFile.reset(new std::fstream(strPath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc));
+		if (!pFile->is_open())
+		{
+			return nullptr;
+		}
+		std::vector<std::uint8_t> vecHeader(k_uiHeaderBytes, 0);
+		memcpy(vecHeader.data(), k_arrMagic, sizeof(k_arrMagic));
+		writeUint32(vecHeader.data() + 4, k_uiVersion);
+		pFile->write(reinterpret_cast<const char*>(vecHeader.data()), static_cast<std::streamsize>(vecHeader.size()));
+		pFile->flush();
+		if (!pFile->good())
+		{
+			return nullptr;
+		}
+	}
+
+	std::fstream* const pOpened = pFile.get();
+	m_mapFiles.emplace(xRegion, std::move(pFile));
+	return pOpened;
+}
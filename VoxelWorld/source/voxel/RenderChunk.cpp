@@ -1,60 +1,122 @@
 #include "voxel/RenderChunk.h"
 
+#include <vector>
+
 
 /**
  * Destructor
- * Frees up allocated GPU memory.
+ * Releases the vertices in the arena.
  */
 RenderChunk::~RenderChunk()
 {
-	glDeleteBuffers(1, &m_uiVertexBufferObject);
-	glDeleteVertexArrays(1, &m_uiVertexArrayObject);
+	m_xArena.free(m_xAllocation);
 }
 
 
 /**
  * Move constructor
- * Invalidates GPU object handles to ensure memory remains valid for new object.
+ * Takes over the vertices, the other object no longer releases them.
  */
 RenderChunk::RenderChunk(RenderChunk&& xOther)
-	: m_uiVertexArrayObject(xOther.m_uiVertexArrayObject), m_uiVertexBufferObject(xOther.m_uiVertexBufferObject), k_uiNumVertices(xOther.k_uiNumVertices)
+	: m_xArena(xOther.m_xArena), m_xAllocation(xOther.m_xAllocation), k_iLod(xOther.k_iLod), k_arrNeighbourLods(xOther.k_arrNeighbourLods), k_iMinHeight(xOther.k_iMinHeight), k_iMaxHeight(xOther.k_iMaxHeight),
+	  k_arrOccluderHeights(xOther.k_arrOccluderHeights), k_arrConnectivity(xOther.k_arrConnectivity)
 {
-	xOther.m_uiVertexArrayObject = 0;
-	xOther.m_uiVertexBufferObject = 0;
+	xOther.m_xAllocation.uiVertexCount = 0;
 }
 
 
 /**
  * Constructs a new render chunk given the vertices.
  *
- * @param vecVertices  Vector of vertices which build up this render chunk
+ * @param xArena       Arena holding the vertices
+ * @param xAllocation  Vertices of this chunk within the arena, released when the render chunk is destroyed
+ * @param iLod         Level of detail of the mesh, 0 for full resolution
+ * @param arrNeighbourLods  Levels of detail of the neighbours the mesh was generated for
+ * @param iMinHeight   Lowest layer of the chunk which has visible faces
+ * @param iMaxHeight   One more than the highest layer of the chunk which has visible faces
+ * @param arrOccluderHeights  Heights up to which the cells of the chunk are solid
+ * @param arrConnectivity     Faces connected by air within each section of the chunk
+ */
+RenderChunk::RenderChunk(VertexArena& xArena, const VertexArena::Allocation& xAllocation, const int iLod, const NeighbourLods& arrNeighbourLods, const int iMinHeight, const int iMaxHeight, const OccluderHeights& arrOccluderHeights,
+	const VisibilityGraph::ChunkConnectivity& arrConnectivity)
+	: m_xArena(xArena), m_xAllocation(xAllocation), k_iLod(iLod), k_arrNeighbourLods(arrNeighbourLods), k_iMinHeight(iMinHeight), k_iMaxHeight(iMaxHeight), k_arrOccluderHeights(arrOccluderHeights),
+	  k_arrConnectivity(arrConnectivity)
+{
+}
+
+
+/**
+ * @return GPU memory [bytes] used by the vertices of this chunk
+ */
+std::size_t RenderChunk::getByteSize() const
+{
+	return m_xAllocation.uiVertexCount * sizeof(PackedVertex);
+}
+
+
+/**
+ * @return level of detail of the mesh, 0 for full resolution
+ */
+int RenderChunk::getLod() const
+{
+	return k_iLod;
+}
+
+
+/**
+ * @return levels of detail of the neighbours the mesh was generated for, which decide about its skirts
+ */
+const RenderChunk::NeighbourLods& RenderChunk::getNeighbourLods() const
+{
+	return k_arrNeighbourLods;
+}
+
+
+/**
+ * @return lowest layer of the chunk which has visible faces, the lower bound of its bounding box
+ */
+int RenderChunk::getMinHeight() const
+{
+	return k_iMinHeight;
+}
+
+
+/**
+ * @return one more than the highest layer of the chunk which has visible faces, the upper bound of its bounding box
+ */
+int RenderChunk::getMaxHeight() const
+{
+	return k_iMaxHeight;
+}
+
+
+/**
+ * @param iCellX  Index of the occluder cell along x
+ * @param iCellZ  Index of the occluder cell along z
+ * @return height up to which all voxels of the cell are solid, zero if the cell has a hole down to the bottom
  */
-RenderChunk::RenderChunk(const std::vector<Vertex>& vecVertices)
-	: m_uiVertexArrayObject(0), m_uiVertexBufferObject(0), k_uiNumVertices(static_cast<std::uint32_t>(vecVertices.size()))
+int RenderChunk::getOccluderHeight(const int iCellX, const int iCellZ) const
 {
-	glGenVertexArrays(1, &m_uiVertexArrayObject);
-	glBindVertexArray(m_uiVertexArrayObject);
+	return k_arrOccluderHeights[static_cast<std::size_t>(iCellX * k_iOccluderCells + iCellZ)];
+}
+
 
-	glGenBuffers(1, &m_uiVertexBufferObject);
-	glBindBuffer(GL_ARRAY_BUFFER, m_uiVertexBufferObject);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * k_uiNumVertices, vecVertices.data(), GL_STATIC_DRAW);
-	// Vertex coordinates
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), nullptr);
-	// Texture coordinates
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void*>(offsetof(Vertex, texturePosition)));
+/**
+ * @return faces connected by air within each section of the chunk
+ */
+const VisibilityGraph::ChunkConnectivity& RenderChunk::getConnectivity() const
+{
+	return k_arrConnectivity;
 }
 
 
 /**
-* Renders this chunk
-*
-* @param bWireframe  Whether or not the chunk should be rendered in wireframe mode
-*/
-void RenderChunk::render(const bool bWireframe) const
+ * Queues this chunk to be drawn with the next VertexArena::drawQueued
+ *
+ * @param xPosition  Position of the chunk
+ */
+void RenderChunk::queueDraw(const glm::vec3& xPosition) const
 {
-	glBindVertexArray(static_cast<GLuint>(m_uiVertexArrayObject));
-	glPolygonMode(GL_FRONT_AND_BACK, bWireframe ? GL_LINE : GL_FILL);
-	glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(k_uiNumVertices));
+	// Chunks whose sections are all empty or buried have no vertices and are not queued by the arena
+	m_xArena.queueDraw(m_xAllocation, glm::vec4(xPosition, 0.0f));
 }
@@ -1,199 +1,479 @@
 #include "voxel/RenderChunkGenerator.h"
 #include "TextureAtlas.h"
+#include "voxel/MeshingContext.h"
 #include "voxel/WorldGenerator.h"
 
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
 /**
- * Vertices for a standard cube mesh in NDC.
+ * A chunk downsampled into cells of factor^3 voxels, with an apron of one cell along x and z taken from the downsampled
+ * neighbours, like MeshingContext for whole voxels. The corners of the apron are not filled.
  */
-const std::vector<Vertex> RenderChunkGenerator::k_vecCubeMesh = {
-    // top
-    Vertex(glm::vec3(0.0f, 1.0f, -1.0f), glm::vec2(0.313589f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.600387f)),
-    Vertex(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.313589f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.312806f)),
-    Vertex(glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.601170f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.312806f)),
-
-    Vertex(glm::vec3(0.0f, 1.0f, -1.0f), glm::vec2(0.313589f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.600387f)),
-    Vertex(glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.601170f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.312806f)),
-    Vertex(glm::vec3(1.0f, 1.0f, -1.0f), glm::vec2(0.601170f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.600387f)),
-
-    // bottom
-    Vertex(glm::vec3(1.0f, 0.0f, -1.0f), glm::vec2(0.927016f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.650563f)),
-    Vertex(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.927016f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.938145f)),
-    Vertex(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(0.639435f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.938145f)),
-
-    Vertex(glm::vec3(1.0f, 0.0f, -1.0f), glm::vec2(0.927016f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.650563f)),
-    Vertex(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(0.639435f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.938145f)),
-    Vertex(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.639435f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.650563f)),
-
-    // right
-    Vertex(glm::vec3(1.0f, 1.0f, -1.0f), glm::vec2(0.602356f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.600009f)),
-    Vertex(glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.602502f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.312428f)),
-    Vertex(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.890083f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.312574f)),
-
-    Vertex(glm::vec3(1.0f, 1.0f, -1.0f), glm::vec2(0.602356f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.600009f)),
-    Vertex(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.890083f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.312574f)),
-    Vertex(glm::vec3(1.0f, 0.0f, -1.0f), glm::vec2(0.889937f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.600155f)),
+struct DownsampledVolume {
+    // cells of the chunk along each axis
+    glm::ivec3 dimensions;
+    // cells including the apron, in the order (x + 1, y, z + 1)
+    std::vector<char> cells;
+
+    char& at(const int x, const int y, const int z) {
+        return cells[static_cast<std::size_t>(((x + 1) * dimensions.y + y) * (dimensions.z + 2) + z + 1)];
+    }
 
-    // left
-    Vertex(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.025300f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.601718f)),
-    Vertex(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(0.025154f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.314136f)),
-    Vertex(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.312735f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.313990f)),
+    char operator()(const int x, const int y, const int z) const {
+        return cells[static_cast<std::size_t>(((x + 1) * dimensions.y + y) * (dimensions.z + 2) + z + 1)];
+    }
+};
 
-    Vertex(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.025300f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.601718f)),
-    Vertex(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.312735f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.313990f)),
-    Vertex(glm::vec3(0.0f, 1.0f, -1.0f), glm::vec2(0.312881f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.601572f)),
+/**
+ * Majority vote over the voxels of a cell: the cell is solid if at least half of its voxels are, ties keep thin floors
+ * and walls. A solid cell takes the most frequent block type among its solid voxels.
+ *
+ * `counts` must be all zero, it is left all zero.
+ */
+static char majorityVote(const char* voxels, const int count, std::array<int, 256>& counts) {
+    int solid = 0;
+    int bestCount = 0;
+    char best = BLOCK_AIR;
+    for (int i = 0; i < count; i++) {
+        if (voxels[i] == BLOCK_AIR) {
+            continue;
+        }
+        solid++;
+        const int blockCount = ++counts[static_cast<unsigned char>(voxels[i])];
+        if (blockCount > bestCount) {
+            bestCount = blockCount;
+            best = voxels[i];
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        counts[static_cast<unsigned char>(voxels[i])] = 0;
+    }
+    return 2 * solid >= count ? best : char(BLOCK_AIR);
+}
 
-    // front
-    Vertex(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.313669f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.311237f)),
-    Vertex(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec2(0.314044f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.023656f)),
-    Vertex(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.601625f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.024030f)),
+/**
+ * Downsamples the cells [cellX0, cellX1) x [cellZ0, cellZ1) of a chunk into the volume, shifted by (offsetX, offsetZ)
+ * cells. Cells of uniform sections and cells above the highest column take the value of their voxels without a vote.
+ */
+static void downsample(DownsampledVolume& volume, const Chunk& chunk, const int factor, const int cellX0,
+                       const int cellX1, const int cellZ0, const int cellZ1, const int offsetX, const int offsetZ) {
+    const int cellVoxels = factor * factor * factor;
+    std::array<int, 256> counts = {};
+    // voxels of the cells of one row of cells along z, cell after cell
+    std::vector<char> voxels(static_cast<std::size_t>((cellZ1 - cellZ0) * cellVoxels));
+    char row[CHUNK_SIZE];
+
+    for (int cellX = cellX0; cellX < cellX1; cellX++) {
+        for (int cellY = 0; cellY < volume.dimensions.y; cellY++) {
+            // a cell never spans two sections, as the factor divides the section size
+            const int section = cellY * factor / SECTION_SIZE;
+            if (cellY * factor >= chunk.getMaxTop() || chunk.isSectionUniform(section)) {
+                const char value = cellY * factor >= chunk.getMaxTop() ? char(BLOCK_AIR) : chunk.uniformValue(section);
+                for (int cellZ = cellZ0; cellZ < cellZ1; cellZ++) {
+                    volume.at(cellX + offsetX, cellY, cellZ + offsetZ) = value;
+                }
+                continue;
+            }
 
-    Vertex(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec2(0.313669f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.311237f)),
-    Vertex(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.601625f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.024030f)),
-    Vertex(glm::vec3(1.0f, 1.0f, 0.0f), glm::vec2(0.601250f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.311611f)),
+            for (int dx = 0; dx < factor; dx++) {
+                for (int dy = 0; dy < factor; dy++) {
+                    chunk.decodeRow(cellX * factor + dx, cellY * factor + dy, row);
+                    for (int cellZ = cellZ0; cellZ < cellZ1; cellZ++) {
+                        for (int dz = 0; dz < factor; dz++) {
+                            voxels[static_cast<std::size_t>((cellZ - cellZ0) * cellVoxels + (dx * factor + dy) * factor +
+                                                            dz)] = row[cellZ * factor + dz];
+                        }
+                    }
+                }
+            }
+            for (int cellZ = cellZ0; cellZ < cellZ1; cellZ++) {
+                volume.at(cellX + offsetX, cellY, cellZ + offsetZ) =
+                    majorityVote(&voxels[static_cast<std::size_t>((cellZ - cellZ0) * cellVoxels)], cellVoxels, counts);
+            }
+        }
+    }
+}
 
-    // back
-    Vertex(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.313199f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.889921f)),
-    Vertex(glm::vec3(0.0f, 1.0f, -1.0f), glm::vec2(0.313199f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.602340f)),
-    Vertex(glm::vec3(1.0f, 1.0f, -1.0f), glm::vec2(0.600780f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.602340f)),
+/**
+ * Downsamples a chunk and the border cells of its neighbours into cells of factor^3 voxels.
+ */
+static DownsampledVolume downsampleNeighbourhood(const Chunk& chunk, const Chunk& left, const Chunk& right,
+                                                 const Chunk& back, const Chunk& front, const int factor) {
+    DownsampledVolume volume;
+    volume.dimensions = glm::ivec3(CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE) / factor;
+    const int cellsX = volume.dimensions.x;
+    const int cellsZ = volume.dimensions.z;
+    volume.cells.assign(static_cast<std::size_t>((cellsX + 2) * volume.dimensions.y * (cellsZ + 2)), BLOCK_AIR);
+
+    downsample(volume, chunk, factor, 0, cellsX, 0, cellsZ, 0, 0);
+    downsample(volume, left, factor, cellsX - 1, cellsX, 0, cellsZ, -cellsX, 0);
+    downsample(volume, right, factor, 0, 1, 0, cellsZ, cellsX, 0);
+    downsample(volume, back, factor, 0, cellsX, cellsZ - 1, cellsZ, 0, -cellsZ);
+    downsample(volume, front, factor, 0, cellsX, 0, 1, 0, cellsZ);
+    return volume;
+}
 
-    Vertex(glm::vec3(0.0f, 0.0f, -1.0f), glm::vec2(0.313199f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.889921f)),
-    Vertex(glm::vec3(1.0f, 1.0f, -1.0f), glm::vec2(0.600780f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.602340f)),
-    Vertex(glm::vec3(1.0f, 0.0f, -1.0f), glm::vec2(0.600780f / static_cast<float>(TEXTURE_ATLAS_SIZE), 0.889921f))};
+/**
+ * Meshes a downsampled chunk greedily like meshGreedy, with quads of whole cells. Faces at the top of the chunk are
+ * always visible, faces at the bottom never.
+ *
+ * @return the number of exposed cell faces; minHeight and maxHeight receive the layers with visible faces
+ */
+static std::uint64_t meshDownsampled(std::vector<PackedVertex>& vertices, const DownsampledVolume& volume,
+                                     const int factor, const std::array<RenderChunkGenerator::CubeFace, 6>& faces,
+                                     int& minHeight, int& maxHeight) {
+    const glm::ivec3& dimensions = volume.dimensions;
+    std::vector<char> mask;
+    int minCell = dimensions.y;
+    int maxCell = 0;
+
+    std::uint64_t exposedFaces = 0;
+    for (int f = 0; f < static_cast<int>(faces.size()); f++) {
+        const auto& face = faces[static_cast<std::size_t>(f)];
+        const int d = face.xNormal.x != 0 ? 0 : (face.xNormal.y != 0 ? 1 : 2);
+        const int u = (d + 1) % 3;
+        const int v = (d + 2) % 3;
+        const int sizeU = dimensions[u];
+        const int sizeV = dimensions[v];
+        mask.assign(static_cast<std::size_t>(sizeU * sizeV), BLOCK_AIR);
+
+        for (int slice = 0; slice < dimensions[d]; slice++) {
+            glm::ivec3 cell(0);
+            cell[d] = slice;
+            for (int a = 0; a < sizeU; a++) {
+                for (int b = 0; b < sizeV; b++) {
+                    cell[u] = a;
+                    cell[v] = b;
+                    const char block = volume(cell.x, cell.y, cell.z);
+                    const glm::ivec3 neighbour = cell + face.xNormal;
+                    if (block == BLOCK_AIR || neighbour.y < 0 ||
+                        (neighbour.y < dimensions.y && volume(neighbour.x, neighbour.y, neighbour.z) != BLOCK_AIR)) {
+                        continue;
+                    }
+                    mask[static_cast<std::size_t>(a * sizeV + b)] = block;
+                    minCell = std::min(minCell, cell.y);
+                    maxCell = std::max(maxCell, cell.y + 1);
+                    exposedFaces++;
+                }
+            }
+            ChunkMesher::coverMask(vertices, mask, face, f, cell, u, v, sizeU, sizeV, factor);
+        }
+    }
 
-static bool needsRender(const Chunk& chunk, const int x, const int y, const int z, const glm::ivec3& position,
-                        WorldGenerator& worldGenerator) {
+    minHeight = minCell < maxCell ? minCell * factor : 0;
+    maxHeight = minCell < maxCell ? maxCell * factor : 0;
+    return exposedFaces;
+}
 
-    if (x < 0) {
-        const auto adjacentChunk = worldGenerator.getChunk(position + glm::ivec3(-1, 0, 0));
-        return (*adjacentChunk)(CHUNK_SIZE - 1, y, z) == BLOCK_AIR;
-    }
-    if (y < 0) {
-        // never render a block below lowest point
-        return false;
-    }
-    if (z < 0) {
-        const auto adjacentChunk = worldGenerator.getChunk(position + glm::ivec3(0, 0, -1));
-        return (*adjacentChunk)(x, y, CHUNK_SIZE - 1) == BLOCK_AIR;
+/**
+ * Emits the skirts of a mesh towards the neighbours of another level of detail: the faces towards the neighbouring
+ * chunk of the solid cells of every border column within k_iSkirtCells cells of the coarser level below the top, unless
+ * they are visible anyway. They cover the crack to a neighbour whose surface ends lower at the border.
+ *
+ * The volume holds cells of `scale` voxels, i.e. of level lod, with an apron of one cell along x and z.
+ *
+ * @return lowest layer covered by a skirt, CHUNK_HEIGHT if there is none
+ */
+template <class Volume>
+static int emitSkirts(std::vector<PackedVertex>& vertices, const Volume& volume, const glm::ivec3& dimensions,
+                      const int scale, const int lod, const RenderChunkGenerator::NeighbourLods& neighbourLods,
+                      const std::array<RenderChunkGenerator::CubeFace, 6>& faces) {
+    std::vector<char> mask;
+    int lowest = CHUNK_HEIGHT;
+    for (int f = 0; f < static_cast<int>(faces.size()); f++) {
+        const auto& face = faces[static_cast<std::size_t>(f)];
+        if (face.xNormal.y != 0) {
+            continue;
+        }
+        // the side faces follow top and bottom
+        const int neighbourLod = neighbourLods[static_cast<std::size_t>(f - 2)];
+        if (neighbourLod == lod) {
+            continue;
+        }
+        const int skirtCells = RenderChunkGenerator::k_iSkirtCells << std::max(0, neighbourLod - lod);
+        const int d = face.xNormal.x != 0 ? 0 : 2;
+        const int u = (d + 1) % 3;
+        const int v = (d + 2) % 3;
+        const int sizeU = dimensions[u];
+        const int sizeV = dimensions[v];
+        // the border columns lie along the horizontal axis of the slice
+        const int h = 2 - d;
+        mask.assign(static_cast<std::size_t>(sizeU * sizeV), BLOCK_AIR);
+
+        glm::ivec3 cell(0);
+        cell[d] = face.xNormal[d] > 0 ? dimensions[d] - 1 : 0;
+        for (int i = 0; i < dimensions[h]; i++) {
+            cell[h] = i;
+            int top = dimensions.y;
+            while (top > 0 && volume(cell.x, top - 1, cell.z) == BLOCK_AIR) {
+                top--;
+            }
+            for (int y = std::max(0, top - skirtCells); y < top; y++) {
+                const char block = volume(cell.x, y, cell.z);
+                if (block == BLOCK_AIR || volume(cell.x + face.xNormal.x, y, cell.z + face.xNormal.z) == BLOCK_AIR) {
+                    continue;
+                }
+                cell.y = y;
+                mask[static_cast<std::size_t>(cell[u] * sizeV + cell[v])] = block;
+                lowest = std::min(lowest, y * scale);
+            }
+        }
+        ChunkMesher::coverMask(vertices, mask, face, f, cell, u, v, sizeU, sizeV, scale);
     }
+    return lowest;
+}
 
-    if (x == CHUNK_SIZE) {
-        const auto adjacentChunk = worldGenerator.getChunk(position + glm::ivec3(1, 0, 0));
-        return (*adjacentChunk)(0, y, z) == BLOCK_AIR;
-    }
-    if (y == CHUNK_HEIGHT) {
-        // there will never be a block heigher than this, always render
-        return true;
-    }
-    if (z == CHUNK_SIZE) {
-        const auto adjacentChunk = worldGenerator.getChunk(position + glm::ivec3(0, 0, 1));
-        return (*adjacentChunk)(x, y, 0) == BLOCK_AIR;
+/**
+ * Finds the heights up to which the occluder cells of a chunk are solid, the lowest column floor within every cell.
+ */
+static RenderChunk::OccluderHeights occluderHeights(const Chunk& chunk) {
+    const int cellSize = CHUNK_SIZE / RenderChunk::k_iOccluderCells;
+    RenderChunk::OccluderHeights heights;
+    for (int cellX = 0; cellX < RenderChunk::k_iOccluderCells; cellX++) {
+        for (int cellZ = 0; cellZ < RenderChunk::k_iOccluderCells; cellZ++) {
+            int height = CHUNK_HEIGHT;
+            for (int x = cellX * cellSize; x < (cellX + 1) * cellSize; x++) {
+                for (int z = cellZ * cellSize; z < (cellZ + 1) * cellSize; z++) {
+                    height = std::min(height, chunk.columnFloor(x, z));
+                }
+            }
+            heights[static_cast<std::size_t>(cellX * RenderChunk::k_iOccluderCells + cellZ)] =
+                static_cast<std::uint8_t>(height);
+        }
     }
-    return chunk(x, y, z) == BLOCK_AIR;
+    return heights;
 }
 
-RenderChunkGenerator::RenderChunkGenerator(std::size_t cacheSize) : chunkCache(cacheSize) {
+RenderChunkGenerator::RenderChunkGenerator(std::size_t cacheBytes)
+    : m_xArena(static_cast<std::uint32_t>(cacheBytes / 4 * 5 / sizeof(PackedVertex)), RenderChunk::k_uiMaxQuads),
+      chunkCache(cacheBytes, [](const RenderChunk& renderChunk) { return renderChunk.getByteSize(); }), m_eMeshingMode(MeshingMode::eGreedy), m_uiGeneration(0),
+      // the generation workers of WorldGenerator run alongside and take the smaller share of the cores
+      m_xThreadPool(ThreadPool::defaultThreadCount(0, 2)) {
 }
 
-const std::shared_ptr<RenderChunk> RenderChunkGenerator::fromChunk(const glm::ivec3 position, const Chunk& chunk,
-                                                   WorldGenerator& worldGenerator) {
-    // Return the chunk from the cache if it exists
+const std::shared_ptr<RenderChunk> RenderChunkGenerator::fromChunk(const glm::ivec3 position, const int lod,
+                                                                   const NeighbourLods& neighbourLods,
+                                                                   WorldGenerator& worldGenerator) {
+    // Return the chunk from the cache if it exists at the requested level of detail with skirts for the levels of its
+    // neighbours. Another mesh is still returned while the chunk is meshed again.
 
     auto cacheEntry = chunkCache.get(position);
-    if (cacheEntry) {
+    if (cacheEntry && cacheEntry->getLod() == lod && cacheEntry->getNeighbourLods() == neighbourLods) {
         return cacheEntry;
     }
 
-    std::vector<Vertex> vs;
+    if (m_setPending.count(position) != 0) {
+        // already being meshed
+        return cacheEntry;
+    }
 
-    const float textureAtlasSize = static_cast<float>(TEXTURE_ATLAS_SIZE);
+    // The chunk and its neighbours must have been generated, the workers only read them. Missing ones are requested
+    // from the world generator and meshing is retried on a later frame.
+    const std::shared_ptr<const Chunk> chunk = worldGenerator.findChunk(position);
+    const std::shared_ptr<const Chunk> left = worldGenerator.findChunk(position + glm::ivec3(-1, 0, 0));
+    const std::shared_ptr<const Chunk> right = worldGenerator.findChunk(position + glm::ivec3(1, 0, 0));
+    const std::shared_ptr<const Chunk> back = worldGenerator.findChunk(position + glm::ivec3(0, 0, -1));
+    const std::shared_ptr<const Chunk> front = worldGenerator.findChunk(position + glm::ivec3(0, 0, 1));
+    if (!chunk || !left || !right || !back || !front) {
+        worldGenerator.requestChunk(position);
+        worldGenerator.requestChunk(position + glm::ivec3(-1, 0, 0));
+        worldGenerator.requestChunk(position + glm::ivec3(1, 0, 0));
+        worldGenerator.requestChunk(position + glm::ivec3(0, 0, -1));
+        worldGenerator.requestChunk(position + glm::ivec3(0, 0, 1));
+        return cacheEntry;
+    }
 
-    for (int x = 0; x < CHUNK_SIZE; x++) {
-        for (int y = 0; y < CHUNK_HEIGHT; y++) {
-            for (int z = 0; z < CHUNK_SIZE; z++) {
-                if (chunk(x, y, z) == BLOCK_AIR) {
-                    continue;
-                }
+    // keep the chunks stored while they are meshed, so a frame revisiting them does not generate them again
+    const std::array<glm::ivec3, 5> neighbourhood = {{position, position + glm::ivec3(-1, 0, 0),
+        position + glm::ivec3(1, 0, 0), position + glm::ivec3(0, 0, -1), position + glm::ivec3(0, 0, 1)}};
+    for (const auto& pinned : neighbourhood) {
+        worldGenerator.pinChunk(pinned);
+    }
 
-                // position offset
-                const auto po = glm::vec3(x, y, z);
+    m_setPending.insert(position);
+    const MeshingMode mode = m_eMeshingMode;
+    const std::uint64_t generation = m_uiGeneration;
+    WorldGenerator* const generator = &worldGenerator;
+
+    m_xThreadPool.submit([this, position, lod, neighbourLods, chunk, left, right, back, front, mode, generation,
+                          generator, neighbourhood]() {
+        MeshingResult result;
+        result.xPosition = position;
+        result.uiGeneration = generation;
+        result.iLod = lod;
+        result.arrNeighbourLods = neighbourLods;
+
+        const auto start = std::chrono::steady_clock::now();
+        if (lod == 0) {
+            const MeshingContext context(*chunk, *left, *right, *back, *front);
+            result.uiExposedFaces = ChunkMesher::meshChunk(result.vecVertices, context, mode);
+            result.uiSkippedSections = static_cast<std::uint64_t>(context.getSkippedSectionCount());
+            const std::size_t meshVertices = result.vecVertices.size();
+            const int skirtHeight = emitSkirts(result.vecVertices, context,
+                                               glm::ivec3(CHUNK_SIZE, CHUNK_HEIGHT, CHUNK_SIZE), 1, lod, neighbourLods,
+                                               ChunkMesher::k_arrCubeFaces);
+            result.uiSkirtVertices = result.vecVertices.size() - meshVertices;
+            result.iMinHeight = std::min(context.getMeshedBegin(), skirtHeight);
+            result.iMaxHeight = context.getMeshedEnd();
+        } else {
+            const int factor = 1 << lod;
+            const DownsampledVolume volume = downsampleNeighbourhood(*chunk, *left, *right, *back, *front, factor);
+            result.uiExposedFaces = meshDownsampled(result.vecVertices, volume, factor, ChunkMesher::k_arrCubeFaces,
+                                                    result.iMinHeight, result.iMaxHeight);
+            result.uiSkippedSections = 0;
+            const std::size_t meshVertices = result.vecVertices.size();
+            const int skirtHeight = emitSkirts(result.vecVertices, volume, volume.dimensions, factor, lod, neighbourLods,
+                                               ChunkMesher::k_arrCubeFaces);
+            result.uiSkirtVertices = result.vecVertices.size() - meshVertices;
+            result.iMinHeight = std::min(result.iMinHeight, skirtHeight);
+        }
+        const std::chrono::duration<double> meshingTime = std::chrono::steady_clock::now() - start;
+        result.dMeshingTime = meshingTime.count();
 
-                // texture coordinate offset
-                const auto tco = glm::vec2(static_cast<float>(chunk(x, y, z) - 1) / textureAtlasSize, 0.0f);
+        // culling data, not part of the meshing time
+        result.arrOccluderHeights = occluderHeights(*chunk);
+        result.arrConnectivity = VisibilityGraph::computeConnectivity(*chunk);
 
-                const float cs = static_cast<float>(CHUNK_SIZE);
+        for (const auto& pinned : neighbourhood) {
+            generator->unpinChunk(pinned);
+        }
 
-                // top
-                if (needsRender(chunk, x, y + 1, z, position, worldGenerator)) {
-                    vs.push_back(Vertex((k_vecCubeMesh[0].position + po) / cs, k_vecCubeMesh[0].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[1].position + po) / cs, k_vecCubeMesh[1].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[2].position + po) / cs, k_vecCubeMesh[2].texturePosition + tco));
+        std::lock_guard<std::mutex> lock(m_xResultMutex);
+        m_vecResults.push_back(std::move(result));
+    });
 
-                    vs.push_back(Vertex((k_vecCubeMesh[3].position + po) / cs, k_vecCubeMesh[3].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[4].position + po) / cs, k_vecCubeMesh[4].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[5].position + po) / cs, k_vecCubeMesh[5].texturePosition + tco));
-                }
+    return cacheEntry;
+}
 
-                // bottom
-                if (needsRender(chunk, x, y - 1, z, position, worldGenerator)) {
-                    vs.push_back(Vertex((k_vecCubeMesh[6].position + po) / cs, k_vecCubeMesh[6].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[7].position + po) / cs, k_vecCubeMesh[7].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[8].position + po) / cs, k_vecCubeMesh[8].texturePosition + tco));
+const std::shared_ptr<RenderChunk> RenderChunkGenerator::findRenderChunk(const glm::ivec3 position) const {
+    return chunkCache.peek(position);
+}
 
-                    vs.push_back(Vertex((k_vecCubeMesh[9].position + po) / cs, k_vecCubeMesh[9].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[10].position + po) / cs, k_vecCubeMesh[10].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[11].position + po) / cs, k_vecCubeMesh[11].texturePosition + tco));
-                }
+std::size_t RenderChunkGenerator::uploadMeshedChunks(const std::size_t byteBudget,
+                                                     const std::function<float(const glm::ivec3&)>& importance) {
+    {
+        std::lock_guard<std::mutex> lock(m_xResultMutex);
+        for (auto& result : m_vecResults) {
+            m_vecReady.push_back(std::move(result));
+        }
+        m_vecResults.clear();
+    }
 
-                // right
-                if (needsRender(chunk, x + 1, y, z, position, worldGenerator)) {
-                    vs.push_back(Vertex((k_vecCubeMesh[12].position + po) / cs, k_vecCubeMesh[12].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[13].position + po) / cs, k_vecCubeMesh[13].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[14].position + po) / cs, k_vecCubeMesh[14].texturePosition + tco));
+    // most important first, the importance is evaluated once per mesh
+    std::vector<std::pair<float, std::size_t>> order;
+    order.reserve(m_vecReady.size());
+    for (std::size_t i = 0; i < m_vecReady.size(); i++) {
+        order.emplace_back(importance(m_vecReady[i].xPosition), i);
+    }
+    std::sort(order.begin(), order.end(),
+              [](const std::pair<float, std::size_t>& a, const std::pair<float, std::size_t>& b) {
+                  return a.first > b.first;
+              });
+
+    std::size_t uploadedBytes = 0;
+    std::vector<MeshingResult> remaining;
+    for (const auto& entry : order) {
+        MeshingResult& result = m_vecReady[entry.second];
+        if (result.uiGeneration != m_uiGeneration) {
+            // meshed with outdated settings, the chunk has been queued again since
+            continue;
+        }
+        if (entry.first < 0.0f) {
+            // out of reach, the chunk is meshed again if it comes back into view
+            m_setPending.erase(result.xPosition);
+            continue;
+        }
+        if (uploadedBytes > 0 && uploadedBytes >= byteBudget) {
+            remaining.push_back(std::move(result));
+            continue;
+        }
 
-                    vs.push_back(Vertex((k_vecCubeMesh[15].position + po) / cs, k_vecCubeMesh[15].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[16].position + po) / cs, k_vecCubeMesh[16].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[17].position + po) / cs, k_vecCubeMesh[17].texturePosition + tco));
-                }
+        // The arena has some headroom over the cache budget, but it can be too fragmented for a large mesh. The least
+        // recently used chunks are given up then. If the mesh still does not fit, it is kept for the next frame, when
+        // the pages have been compacted.
+        VertexArena::Allocation allocation;
+        bool allocated = m_xArena.allocate(result.vecVertices, allocation);
+        while (!allocated && chunkCache.evictLeastRecent()) {
+            allocated = m_xArena.allocate(result.vecVertices, allocation);
+        }
+        if (!allocated) {
+            m_xStatistics.uiFailedUploads++;
+            remaining.push_back(std::move(result));
+            continue;
+        }
 
-                // left
-                if (needsRender(chunk, x - 1, y, z, position, worldGenerator)) {
-                    vs.push_back(Vertex((k_vecCubeMesh[18].position + po) / cs, k_vecCubeMesh[18].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[19].position + po) / cs, k_vecCubeMesh[19].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[20].position + po) / cs, k_vecCubeMesh[20].texturePosition + tco));
+        m_setPending.erase(result.xPosition);
+        uploadedBytes += result.vecVertices.size() * sizeof(PackedVertex);
+
+        // the downsampled meshes and the skirts would skew the comparison of the meshing strategies
+        if (result.iLod == 0) {
+            m_xStatistics.uiLastNaiveVertices = result.uiExposedFaces * 4;
+            m_xStatistics.uiLastVertices = result.vecVertices.size() - result.uiSkirtVertices;
+            m_xStatistics.uiTotalNaiveVertices += m_xStatistics.uiLastNaiveVertices;
+            m_xStatistics.uiTotalVertices += m_xStatistics.uiLastVertices;
+            m_xStatistics.uiMeshedChunks++;
+            m_xStatistics.uiSkippedSections += result.uiSkippedSections;
+            m_xStatistics.dLastMeshingTime = result.dMeshingTime;
+            m_xStatistics.dTotalMeshingTime += result.dMeshingTime;
+        } else {
+            m_xStatistics.uiDownsampledChunks++;
+        }
 
-                    vs.push_back(Vertex((k_vecCubeMesh[21].position + po) / cs, k_vecCubeMesh[21].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[22].position + po) / cs, k_vecCubeMesh[22].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[23].position + po) / cs, k_vecCubeMesh[23].texturePosition + tco));
-                }
+        // Create the chunk, add it to the cache
+        chunkCache.set(result.xPosition,
+                       std::make_shared<RenderChunk>(m_xArena, allocation, result.iLod, result.arrNeighbourLods, result.iMinHeight, result.iMaxHeight,
+                                                     result.arrOccluderHeights, result.arrConnectivity));
+    }
+    m_vecReady.swap(remaining);
 
-                // front
-                if (needsRender(chunk, x, y, z + 1, position, worldGenerator)) {
-                    vs.push_back(Vertex((k_vecCubeMesh[24].position + po) / cs, k_vecCubeMesh[24].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[25].position + po) / cs, k_vecCubeMesh[25].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[26].position + po) / cs, k_vecCubeMesh[26].texturePosition + tco));
+    return uploadedBytes;
+}
 
-                    vs.push_back(Vertex((k_vecCubeMesh[27].position + po) / cs, k_vecCubeMesh[27].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[28].position + po) / cs, k_vecCubeMesh[28].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[29].position + po) / cs, k_vecCubeMesh[29].texturePosition + tco));
-                }
+std::size_t RenderChunkGenerator::getReadyCount() const {
+    return m_vecReady.size();
+}
 
-                // back
-                if (needsRender(chunk, x, y, z - 1, position, worldGenerator)) {
-                    vs.push_back(Vertex((k_vecCubeMesh[30].position + po) / cs, k_vecCubeMesh[30].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[31].position + po) / cs, k_vecCubeMesh[31].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[32].position + po) / cs, k_vecCubeMesh[32].texturePosition + tco));
+std::size_t RenderChunkGenerator::getPendingCount() const {
+    return m_setPending.size();
+}
 
-                    vs.push_back(Vertex((k_vecCubeMesh[33].position + po) / cs, k_vecCubeMesh[33].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[34].position + po) / cs, k_vecCubeMesh[34].texturePosition + tco));
-                    vs.push_back(Vertex((k_vecCubeMesh[35].position + po) / cs, k_vecCubeMesh[35].texturePosition + tco));
-                }
-            }
-        }
+void RenderChunkGenerator::setMeshingMode(const MeshingMode eMeshingMode) {
+    if (eMeshingMode == m_eMeshingMode) {
+        return;
     }
+    m_eMeshingMode = eMeshingMode;
+    m_xStatistics = Statistics();
+    chunkCache.clear();
+    m_setPending.clear();
+    m_uiGeneration++;
+}
+
+RenderChunkGenerator::MeshingMode RenderChunkGenerator::getMeshingMode() const {
+    return m_eMeshingMode;
+}
+
+const RenderChunkGenerator::Statistics& RenderChunkGenerator::getStatistics() const {
+    return m_xStatistics;
+}
+
+const LimitedUnorderedMap<glm::ivec3, RenderChunk>::Statistics& RenderChunkGenerator::getCacheStatistics() const {
+    return chunkCache.getStatistics();
+}
+
+std::size_t RenderChunkGenerator::getCachedChunkCount() const {
+    return chunkCache.size();
+}
 
-    // Create the chunk, add it to the cache
-    auto renderChunk = std::make_shared<RenderChunk>(vs);
-    chunkCache.set(position, renderChunk);
+std::size_t RenderChunkGenerator::getCachedBytes() const {
+    return chunkCache.getTotalCost();
+}
+
+void RenderChunkGenerator::drawQueued(const bool wireframe) {
+    m_xArena.drawQueued(wireframe);
+}
 
-    return renderChunk;
+const VertexArena& RenderChunkGenerator::getArena() const {
+    return m_xArena;
 }
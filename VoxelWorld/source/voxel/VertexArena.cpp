@@ -0,0 +1,272 @@
+#include "voxel/VertexArena.h"
+
+#include <cstring>
+
+
+
+/**
+ * Creates the buffers and the vertex array.
+ * The index buffer triangulates uiMaxQuads quads of four consecutive vertices each, the base vertex of a draw selects
+ * the mesh, so no mesh needs its own indices. The vertex buffer page is bound per draw call.
+ *
+ * @param uiCapacity  Number of vertices the arena can hold, rounded up to whole pages
+ * @param uiMaxQuads  Upper bound for the number of quads of a single mesh
+ */
+VertexArena::VertexArena(const std::uint32_t uiCapacity, const std::uint32_t uiMaxQuads)
+	: m_uiVertexArrayObject(0),
+	  m_xAllocator(k_xPageSize, sizeof(PackedVertex), static_cast<std::uint32_t>((static_cast<std::uint64_t>(uiCapacity) * sizeof(PackedVertex) + k_xPageSize - 1) / k_xPageSize), voxel::Buffer::Usage::eVertex),
+	  m_uiIndexBufferObject(0), m_xStreamBuffer(k_xStreamBufferSize), m_xStorageAlignment(0), m_uiLastDrawnMeshes(0), m_uiLastDrawnTriangles(0), m_uiLastDrawCalls(0), m_uiLastStateChanges(0)
+{
+	GLint iStorageAlignment = 0;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &iStorageAlignment);
+	m_xStorageAlignment = static_cast<voxel::RingBuffer::size_type>(iStorageAlignment);
+
+	std::vector<std::uint32_t> vecIndices;
+	vecIndices.reserve(uiMaxQuads * 6);
+	for (std::uint32_t uiQuad = 0; uiQuad < uiMaxQuads; ++uiQuad)
+	{
+		const std::uint32_t uiFirst = uiQuad * 4;
+		vecIndices.push_back(uiFirst);
+		vecIndices.push_back(uiFirst + 1);
+		vecIndices.push_back(uiFirst + 2);
+		vecIndices.push_back(uiFirst);
+		vecIndices.push_back(uiFirst + 2);
+		vecIndices.push_back(uiFirst + 3);
+	}
+
+	glGenVertexArrays(1, &m_uiVertexArrayObject);
+	glBindVertexArray(m_uiVertexArrayObject);
+
+	// Packed position, face and texture tile, unpacked by the vertex shader
+	glEnableVertexAttribArray(0);
+	glVertexAttribIFormat(0, 1, GL_UNSIGNED_INT, 0);
+	glVertexAttribBinding(0, 0);
+
+	// The element buffer binding is part of the vertex array state
+	glGenBuffers(1, &m_uiIndexBufferObject);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_uiIndexBufferObject);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(std::uint32_t) * vecIndices.size()), vecIndices.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+}
+
+
+/**
+ * Destructor, frees the GPU memory.
+ * The vertex buffer pages and the stream buffer free themselves.
+ */
+VertexArena::~VertexArena()
+{
+	glDeleteBuffers(1, &m_uiIndexBufferObject);
+	glDeleteVertexArrays(1, &m_uiVertexArrayObject);
+}
+
+
+/**
+ * Uploads a mesh into the first unused range large enough to hold it
+ *
+ * @param vecVertices  Vertices of the mesh, four per quad
+ * @param xAllocation  Receives the range of the mesh
+ * @return false if all pages are full or too fragmented, the arena is not changed then
+ */
+bool VertexArena::allocate(const std::vector<PackedVertex>& vecVertices, Allocation& xAllocation)
+{
+	const std::uint32_t uiCount = static_cast<std::uint32_t>(vecVertices.size());
+	xAllocation.uiHandle = voxel::BufferAllocator::k_uiInvalidHandle;
+	xAllocation.uiVertexCount = uiCount;
+	if (uiCount == 0)
+	{
+		return true;
+	}
+
+	const auto xSize = static_cast<voxel::BufferAllocator::size_type>(sizeof(PackedVertex) * uiCount);
+	xAllocation.uiHandle = m_xAllocator.allocate(xSize);
+	if (xAllocation.uiHandle == voxel::BufferAllocator::k_uiInvalidHandle)
+	{
+		return false;
+	}
+
+	voxel::RingBuffer::size_type xStreamOffset;
+	void* const pStreamMemory = m_xStreamBuffer.allocate(xSize, sizeof(PackedVertex), xStreamOffset);
+	if (pStreamMemory != nullptr)
+	{
+		memcpy(pStreamMemory, vecVertices.data(), xSize);
+		m_xAllocator.copy(xAllocation.uiHandle, m_xStreamBuffer.handle(), xStreamOffset, xSize);
+	}
+	else
+	{
+		m_xAllocator.upload(xAllocation.uiHandle, vecVertices.data(), xSize);
+	}
+	return true;
+}
+
+
+/**
+ * Releases the range of a mesh
+ *
+ * @param xAllocation  Range returned by allocate
+ */
+void VertexArena::free(const Allocation& xAllocation)
+{
+	if (xAllocation.uiVertexCount > 0)
+	{
+		m_xAllocator.free(xAllocation.uiHandle);
+	}
+}
+
+
+/**
+ * Queues a mesh to be drawn by the next call of drawQueued
+ *
+ * @param xAllocation  Range of the mesh
+ * @param xOffset      Translation of the mesh
+ */
+void VertexArena::queueDraw(const Allocation& xAllocation, const glm::vec4& xOffset)
+{
+	if (xAllocation.uiVertexCount == 0)
+	{
+		return;
+	}
+
+	const voxel::BufferAllocator::Block& xBlock = m_xAllocator.block(xAllocation.uiHandle);
+	DrawElementsIndirectCommand xCommand;
+	xCommand.uiCount = xAllocation.uiVertexCount / 4 * 6;
+	xCommand.uiInstanceCount = 1;
+	xCommand.uiFirstIndex = 0;
+	xCommand.iBaseVertex = static_cast<std::int32_t>(xBlock.xOffset / sizeof(PackedVertex));
+	xCommand.uiBaseInstance = static_cast<std::uint32_t>(m_vecOffsets.size());
+	if (m_vecPageCommands.size() <= xBlock.uiPage)
+	{
+		m_vecPageCommands.resize(xBlock.uiPage + 1);
+	}
+	m_vecPageCommands[xBlock.uiPage].push_back(xCommand);
+	m_vecOffsets.push_back(xOffset);
+}
+
+
+/**
+ * Draws all queued meshes with one call per page, clears the queue and compacts the pages.
+ * The commands of all pages and the chunk offsets share one region of the stream buffer, the offsets are indexed by
+ * the base instance rather than gl_DrawID, which restarts with every call. The stream buffer is fenced after the
+ * draws, which also covers the mesh uploads of this frame. Compaction runs after the draws, as the queued commands
+ * hold the locations of the meshes.
+ *
+ * @param bWireframe  Whether or not the meshes should be rendered in wireframe mode
+ */
+void VertexArena::drawQueued(const bool bWireframe)
+{
+	m_uiLastDrawnMeshes = m_vecOffsets.size();
+	m_uiLastDrawCalls = 0;
+	m_uiLastStateChanges = 0;
+
+	m_uiLastDrawnTriangles = 0;
+	m_vecCommands.clear();
+	for (const auto& vecCommands : m_vecPageCommands)
+	{
+		m_vecCommands.insert(m_vecCommands.end(), vecCommands.begin(), vecCommands.end());
+		for (const auto& xCommand : vecCommands)
+		{
+			m_uiLastDrawnTriangles += xCommand.uiCount / 3;
+		}
+	}
+
+	// One region for both, so writing the offsets cannot recycle the commands before they are read
+	const auto xCommandBytes = static_cast<voxel::RingBuffer::size_type>(sizeof(DrawElementsIndirectCommand) * m_vecCommands.size());
+	const auto xOffsetBytes = static_cast<voxel::RingBuffer::size_type>(sizeof(glm::vec4) * m_vecOffsets.size());
+	const voxel::RingBuffer::size_type xOffsetsStart = (xCommandBytes + m_xStorageAlignment - 1) / m_xStorageAlignment * m_xStorageAlignment;
+	voxel::RingBuffer::size_type xStreamOffset = 0;
+	std::uint8_t* const pStreamMemory = m_vecOffsets.empty() ? nullptr :
+		static_cast<std::uint8_t*>(m_xStreamBuffer.allocate(xOffsetsStart + xOffsetBytes, m_xStorageAlignment, xStreamOffset));
+
+	if (pStreamMemory != nullptr)
+	{
+		memcpy(pStreamMemory, m_vecCommands.data(), xCommandBytes);
+		memcpy(pStreamMemory + xOffsetsStart, m_vecOffsets.data(), xOffsetBytes);
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_xStreamBuffer.handle());
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_xStreamBuffer.handle(), xStreamOffset + xOffsetsStart, xOffsetBytes);
+
+		glBindVertexArray(m_uiVertexArrayObject);
+		glPolygonMode(GL_FRONT_AND_BACK, bWireframe ? GL_LINE : GL_FILL);
+		m_uiLastStateChanges += 4;
+		std::size_t uiFirstCommand = 0;
+		for (std::uint32_t uiPage = 0; uiPage < m_vecPageCommands.size(); ++uiPage)
+		{
+			const auto& vecCommands = m_vecPageCommands[uiPage];
+			if (vecCommands.empty())
+			{
+				continue;
+			}
+			glBindVertexBuffer(0, m_xAllocator.page(uiPage).m_uiHandle, 0, sizeof(PackedVertex));
+			m_uiLastStateChanges++;
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+				reinterpret_cast<const void*>(xStreamOffset + sizeof(DrawElementsIndirectCommand) * uiFirstCommand),
+				static_cast<GLsizei>(vecCommands.size()), 0);
+			uiFirstCommand += vecCommands.size();
+			m_uiLastDrawCalls++;
+		}
+	}
+
+	for (auto& vecCommands : m_vecPageCommands)
+	{
+		vecCommands.clear();
+	}
+	m_vecOffsets.clear();
+	m_xStreamBuffer.fence();
+
+	m_xAllocator.compact(k_xCompactionBytesPerFrame);
+}
+
+
+/**
+ * @return memory usage and fragmentation of the vertex buffer pages
+ */
+voxel::BufferAllocator::Statistics VertexArena::getStatistics() const
+{
+	return m_xAllocator.statistics();
+}
+
+
+/**
+ * @return synchronization statistics of the stream buffer
+ */
+const voxel::RingBuffer::Statistics& VertexArena::getStreamStatistics() const
+{
+	return m_xStreamBuffer.statistics();
+}
+
+
+/**
+ * @return number of meshes drawn by the last call of drawQueued
+ */
+std::size_t VertexArena::getLastDrawnMeshes() const
+{
+	return m_uiLastDrawnMeshes;
+}
+
+
+/**
+ * @return number of triangles drawn by the last call of drawQueued
+ */
+std::size_t VertexArena::getLastDrawnTriangles() const
+{
+	return m_uiLastDrawnTriangles;
+}
+
+
+/**
+ * @return number of draw calls issued by the last call of drawQueued, one per page with queued meshes
+ */
+std::size_t VertexArena::getLastDrawCalls() const
+{
+	return m_uiLastDrawCalls;
+}
+
+
+/**
+ * @return number of GL state changes made by the last call of drawQueued, independent of the number of meshes
+ */
+std::size_t VertexArena::getLastStateChanges() const
+{
+	return m_uiLastStateChanges;
+}
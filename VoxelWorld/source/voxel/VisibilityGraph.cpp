@@ -0,0 +1,293 @@
+#include "voxel/VisibilityGraph.h"
+
+#include <algorithm>
+
+
+static_assert(SECTION_SIZE == CHUNK_SIZE, "Sections must be cubes for the faces to match their neighbours");
+static_assert(SECTION_COUNT <= 8, "The reached sections of a chunk are stored in 8 bits");
+
+/**
+ * Offset to the neighbouring section behind each face, in the order top, bottom, right, left, front, back
+ */
+const std::array<glm::ivec3, 6> VisibilityGraph::k_arrFaceOffsets = {{
+	glm::ivec3(0, 1, 0), glm::ivec3(0, -1, 0), glm::ivec3(1, 0, 0), glm::ivec3(-1, 0, 0), glm::ivec3(0, 0, 1), glm::ivec3(0, 0, -1)
+}};
+
+
+/**
+ * Creates a graph in which no chunk is reachable
+ */
+VisibilityGraph::VisibilityGraph()
+	: m_xMin(0), m_iSizeX(0), m_iSizeZ(0)
+{
+}
+
+
+/**
+ * Flood fills the air of a chunk section by section and records which faces of each section it connects
+ *
+ * @param xChunk  Chunk to analyze
+ * @return connections of the faces of every section
+ */
+VisibilityGraph::ChunkConnectivity VisibilityGraph::computeConnectivity(const Chunk& xChunk)
+{
+	ChunkConnectivity arrConnectivity;
+	for (int iSection = 0; iSection < SECTION_COUNT; ++iSection)
+	{
+		arrConnectivity[static_cast<std::size_t>(iSection)] = computeSectionConnectivity(xChunk, iSection);
+	}
+	return arrConnectivity;
+}
+
+
+/**
+ * @param uiConnectivity  Connections of the faces of a section
+ * @param iFaceA          First face
+ * @param iFaceB          Second face, different from the first
+ * @return whether the two faces are connected
+ */
+bool VisibilityGraph::isConnected(const Connectivity uiConnectivity, const int iFaceA, const int iFaceB)
+{
+	return (uiConnectivity & pairBit(iFaceA, iFaceB)) != 0;
+}
+
+
+/**
+ * Finds the chunks reachable from the section of the camera within a rectangle of chunks.
+ * A camera above the world sees the top sections of all chunks, below the world nothing is hidden.
+ *
+ * @param xCameraSection  Position of the section holding the camera, its index along y may lie above or below the
+ *                        sections of a chunk
+ * @param iMinX           Lowest chunk position along x
+ * @param iMinZ           Lowest chunk position along z
+ * @param iMaxX           One more than the highest chunk position along x
+ * @param iMaxZ           One more than the highest chunk position along z
+ * @param fnConnectivity  Connectivity of the chunk at a position (x, 1, z), all connected for chunks which are not
+ *                        known yet
+ */
+void VisibilityGraph::traverse(const glm::ivec3& xCameraSection, const int iMinX, const int iMinZ, const int iMaxX, const int iMaxZ,
+	const std::function<ChunkConnectivity(const glm::ivec3&)>& fnConnectivity)
+{
+	m_xMin = glm::ivec3(iMinX, 0, iMinZ);
+	m_iSizeX = std::max(0, iMaxX - iMinX);
+	m_iSizeZ = std::max(0, iMaxZ - iMinZ);
+	m_vecVisited.assign(static_cast<std::size_t>(m_iSizeX * m_iSizeZ), 0);
+	m_vecQueue.clear();
+	m_xStatistics = Statistics();
+
+	bool bSkyReached = false;
+	if (xCameraSection.y < 0)
+	{
+		std::fill(m_vecVisited.begin(), m_vecVisited.end(), static_cast<std::uint8_t>((1 << SECTION_COUNT) - 1));
+		m_xStatistics.uiVisitedSections = m_vecVisited.size() * SECTION_COUNT;
+	}
+	else if (xCameraSection.y >= SECTION_COUNT)
+	{
+		bSkyReached = true;
+		visitFromSky();
+	}
+	else
+	{
+		visit(xCameraSection, -1, 0);
+	}
+
+	// Breadth first, the queue is only cleared by the next traversal
+	for (std::size_t uiHead = 0; uiHead < m_vecQueue.size(); ++uiHead)
+	{
+		const Node xNode = m_vecQueue[uiHead];
+		const Connectivity uiConnectivity = fnConnectivity(glm::ivec3(xNode.xSection.x, 1, xNode.xSection.z))[static_cast<std::size_t>(xNode.xSection.y)];
+		for (int iFace = 0; iFace < 6; ++iFace)
+		{
+			if ((xNode.uiDirections & (1 << (iFace ^ 1))) != 0)
+			{
+				continue;
+			}
+			if (xNode.iEnteredFace >= 0 && !isConnected(uiConnectivity, xNode.iEnteredFace, iFace))
+			{
+				continue;
+			}
+
+			const glm::ivec3 xNext = xNode.xSection + k_arrFaceOffsets[static_cast<std::size_t>(iFace)];
+			if (xNext.y >= SECTION_COUNT)
+			{
+				if (!bSkyReached)
+				{
+					bSkyReached = true;
+					visitFromSky();
+				}
+				continue;
+			}
+			visit(xNext, iFace ^ 1, static_cast<std::uint8_t>(xNode.uiDirections | (1 << iFace)));
+		}
+	}
+
+	m_xStatistics.uiReachableChunks = static_cast<std::size_t>(std::count_if(m_vecVisited.begin(), m_vecVisited.end(),
+		[](const std::uint8_t uiSections) { return uiSections != 0; }));
+}
+
+
+/**
+ * @param iX  Chunk position along x
+ * @param iZ  Chunk position along z
+ * @return whether the last traversal reached a section of the chunk, false outside its rectangle
+ */
+bool VisibilityGraph::isReachable(const int iX, const int iZ) const
+{
+	const int iOffsetX = iX - m_xMin.x;
+	const int iOffsetZ = iZ - m_xMin.z;
+	if (iOffsetX < 0 || iOffsetX >= m_iSizeX || iOffsetZ < 0 || iOffsetZ >= m_iSizeZ)
+	{
+		return false;
+	}
+	return m_vecVisited[static_cast<std::size_t>(iOffsetX * m_iSizeZ + iOffsetZ)] != 0;
+}
+
+
+/**
+ * @return counts of the last traversal
+ */
+const VisibilityGraph::Statistics& VisibilityGraph::getStatistics() const
+{
+	return m_xStatistics;
+}
+
+
+/**
+ * @param iFaceA  First face
+ * @param iFaceB  Second face, different from the first
+ * @return bit of the pair of faces in a Connectivity, the pairs are numbered by their lower face first
+ */
+VisibilityGraph::Connectivity VisibilityGraph::pairBit(const int iFaceA, const int iFaceB)
+{
+	const int iLow = std::min(iFaceA, iFaceB);
+	const int iHigh = std::max(iFaceA, iFaceB);
+	return static_cast<Connectivity>(1 << (iLow * 5 - iLow * (iLow - 1) / 2 + iHigh - iLow - 1));
+}
+
+
+/**
+ * Flood fills the air of one section.
+ * Uniform sections are either all air or all solid. Otherwise every region of connected air connects all faces it
+ * touches.
+ *
+ * @param xChunk    Chunk holding the section
+ * @param iSection  Index of the section
+ * @return connections of the faces of the section
+ */
+VisibilityGraph::Connectivity VisibilityGraph::computeSectionConnectivity(const Chunk& xChunk, const int iSection)
+{
+	if (xChunk.isSectionUniform(iSection))
+	{
+		return xChunk.uniformValue(iSection) == BLOCK_AIR ? k_uiAllConnected : 0;
+	}
+
+	// Air voxels not reached by a fill yet, indexed by (x * SECTION_SIZE + y) * SECTION_SIZE + z
+	std::vector<bool> vecOpen(SECTION_SIZE * SECTION_SIZE * SECTION_SIZE);
+	char arrRow[SECTION_SIZE];
+	for (int iX = 0; iX < SECTION_SIZE; ++iX)
+	{
+		for (int iY = 0; iY < SECTION_SIZE; ++iY)
+		{
+			xChunk.decodeRow(iX, iSection * SECTION_SIZE + iY, arrRow);
+			for (int iZ = 0; iZ < SECTION_SIZE; ++iZ)
+			{
+				vecOpen[static_cast<std::size_t>((iX * SECTION_SIZE + iY) * SECTION_SIZE + iZ)] = arrRow[iZ] == BLOCK_AIR;
+			}
+		}
+	}
+
+	Connectivity uiConnectivity = 0;
+	std::vector<glm::ivec3> vecStack;
+	for (int iStart = 0; iStart < SECTION_SIZE * SECTION_SIZE * SECTION_SIZE; ++iStart)
+	{
+		if (!vecOpen[static_cast<std::size_t>(iStart)])
+		{
+			continue;
+		}
+
+		// Faces touched by the region of the start voxel, one bit per face
+		int iFaces = 0;
+		vecOpen[static_cast<std::size_t>(iStart)] = false;
+		vecStack.push_back(glm::ivec3(iStart / (SECTION_SIZE * SECTION_SIZE), iStart / SECTION_SIZE % SECTION_SIZE, iStart % SECTION_SIZE));
+		while (!vecStack.empty())
+		{
+			const glm::ivec3 xVoxel = vecStack.back();
+			vecStack.pop_back();
+			for (int iFace = 0; iFace < 6; ++iFace)
+			{
+				const glm::ivec3 xNext = xVoxel + k_arrFaceOffsets[static_cast<std::size_t>(iFace)];
+				if (xNext.x < 0 || xNext.x >= SECTION_SIZE || xNext.y < 0 || xNext.y >= SECTION_SIZE || xNext.z < 0 || xNext.z >= SECTION_SIZE)
+				{
+					iFaces |= 1 << iFace;
+					continue;
+				}
+				const auto uiNext = static_cast<std::size_t>((xNext.x * SECTION_SIZE + xNext.y) * SECTION_SIZE + xNext.z);
+				if (vecOpen[uiNext])
+				{
+					vecOpen[uiNext] = false;
+					vecStack.push_back(xNext);
+				}
+			}
+		}
+
+		for (int iFaceA = 0; iFaceA < 6; ++iFaceA)
+		{
+			for (int iFaceB = iFaceA + 1; iFaceB < 6; ++iFaceB)
+			{
+				if ((iFaces & (1 << iFaceA)) != 0 && (iFaces & (1 << iFaceB)) != 0)
+				{
+					uiConnectivity = static_cast<Connectivity>(uiConnectivity | pairBit(iFaceA, iFaceB));
+				}
+			}
+		}
+	}
+	return uiConnectivity;
+}
+
+
+/**
+ * Queues a section unless it is outside the rectangle or has been reached before
+ *
+ * @param xSection      Position of the section
+ * @param iEnteredFace  Face by which the section is entered, -1 for the section of the camera
+ * @param uiDirections  Directions moved in to reach the section, one bit per face
+ */
+void VisibilityGraph::visit(const glm::ivec3& xSection, const int iEnteredFace, const std::uint8_t uiDirections)
+{
+	const int iOffsetX = xSection.x - m_xMin.x;
+	const int iOffsetZ = xSection.z - m_xMin.z;
+	if (iOffsetX < 0 || iOffsetX >= m_iSizeX || iOffsetZ < 0 || iOffsetZ >= m_iSizeZ || xSection.y < 0 || xSection.y >= SECTION_COUNT)
+	{
+		return;
+	}
+
+	std::uint8_t& uiVisited = m_vecVisited[static_cast<std::size_t>(iOffsetX * m_iSizeZ + iOffsetZ)];
+	const auto uiBit = static_cast<std::uint8_t>(1 << xSection.y);
+	if ((uiVisited & uiBit) != 0)
+	{
+		return;
+	}
+	uiVisited = static_cast<std::uint8_t>(uiVisited | uiBit);
+	m_xStatistics.uiVisitedSections++;
+
+	Node xNode;
+	xNode.xSection = xSection;
+	xNode.iEnteredFace = iEnteredFace;
+	xNode.uiDirections = uiDirections;
+	m_vecQueue.push_back(xNode);
+}
+
+
+/**
+ * Queues the top sections of all chunks, entered from the air above the world by their top face while moving down
+ */
+void VisibilityGraph::visitFromSky()
+{
+	for (int iX = 0; iX < m_iSizeX; ++iX)
+	{
+		for (int iZ = 0; iZ < m_iSizeZ; ++iZ)
+		{
+			visit(glm::ivec3(m_xMin.x + iX, SECTION_COUNT - 1, m_xMin.z + iZ), 0, 1 << 1);
+		}
+	}
+}
@@ -1,28 +1,328 @@
 #include "voxel/WorldGenerator.h"
+#include "voxel/RegionStore.h"
 #include "TextureAtlas.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
 const double NOISE_SCALE = 0.1;
 
-WorldGenerator::WorldGenerator() : noise(1) {
+const std::size_t DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+// memory used by a stored chunk
+static std::size_t chunkBytes(const Chunk& chunk) {
+    return chunk.byteSize();
+}
+
+// orders the request heap so the chunk nearest to the focus is on top
+static bool isFurther(const glm::ivec3& focus, const glm::ivec3& a, const glm::ivec3& b) {
+    const glm::ivec3 da = a - focus;
+    const glm::ivec3 db = b - focus;
+    return da.x * da.x + da.z * da.z > db.x * db.x + db.z * db.z;
+}
+
+WorldGenerator::WorldGenerator() : memoryBudget(DEFAULT_MEMORY_BUDGET), noise(1), regionStore(std::make_shared<RegionStore>(REGION_DIRECTORY)),
+                                   // the meshing workers of RenderChunkGenerator run alongside and take the larger share
+                                   threadPool(ThreadPool::defaultThreadCount(1, 2)) {
+}
+
+void WorldGenerator::computeHeights(const glm::ivec3& position, int heights[CHUNK_SIZE][CHUNK_SIZE]) const {
+    const std::size_t samples = CHUNK_SIZE * CHUNK_SIZE;
+    double scaledX[samples];
+    double scaledY[samples];
+    double values[samples];
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            const std::size_t index = static_cast<std::size_t>(x * CHUNK_SIZE + z);
+            scaledX[index] = (double(x) / double(CHUNK_SIZE) + double(position.x)) * NOISE_SCALE;
+            scaledY[index] = (double(z) / double(CHUNK_SIZE) + double(position.z)) * NOISE_SCALE;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    noise.octaveNoise0_1(scaledX, scaledY, values, samples, 8);
+    const auto duration = std::chrono::steady_clock::now() - start;
+    noiseSamples += samples;
+    noiseNanoseconds += static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            heights[x][z] = static_cast<int>(values[static_cast<std::size_t>(x * CHUNK_SIZE + z)] * CHUNK_HEIGHT);
+        }
+    }
+}
+
+void WorldGenerator::setSimdNoise(bool enabled) {
+    noise.setSimdEnabled(enabled);
+}
+
+bool WorldGenerator::isSimdNoiseActive() const {
+    return noise.isSimdActive();
+}
+
+double WorldGenerator::getNoiseSamplesPerSecond() const {
+    const std::uint64_t nanoseconds = noiseNanoseconds;
+    return nanoseconds == 0 ? 0.0 : static_cast<double>(noiseSamples) * 1e9 / static_cast<double>(nanoseconds);
+}
+
+void WorldGenerator::setPersistence(bool enabled) {
+    persistence = enabled;
+}
+
+bool WorldGenerator::isPersistenceEnabled() const {
+    return persistence;
+}
+
+const RegionStore& WorldGenerator::getRegionStore() const {
+    return *regionStore;
 }
 
 std::shared_ptr<Chunk> WorldGenerator::getChunk(const glm::ivec3& position) {
+    auto chunk = findChunk(position);
+    if (chunk) {
+        return chunk;
+    }
+
+    bool generated = false;
+    chunk = loadOrGenerateChunk(position, generated);
+    return addChunk(position, chunk, generated);
+}
+
+std::shared_ptr<Chunk> WorldGenerator::loadOrGenerateChunk(const glm::ivec3& position, bool& generated) const {
+    if (persistence) {
+        auto chunk = regionStore->load(position);
+        if (chunk) {
+            generated = false;
+            return chunk;
+        }
+    }
+    generated = true;
+    return generateChunk(position);
+}
+
+std::shared_ptr<Chunk> WorldGenerator::addChunk(const glm::ivec3& position, const std::shared_ptr<Chunk>& chunk, bool generated) {
+    std::shared_ptr<Chunk> stored;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stored = storeChunk(position, chunk, generated);
+    }
+
+    // encoded outside the lock; a chunk another thread stored first has been saved by that thread
+    if (generated && persistence && stored == chunk) {
+        regionStore->save(position, *chunk);
+    }
+    return stored;
+}
+
+std::shared_ptr<Chunk> WorldGenerator::findChunk(const glm::ivec3& position) {
+    std::lock_guard<std::mutex> lock(mutex);
     auto cacheEntry = chunkCache.find(position);
     if (cacheEntry != chunkCache.end()) {
-        return cacheEntry->second;
+        cacheEntry->second.lastAccess = ++accessClock;
+        return cacheEntry->second.chunk;
     }
+    return std::shared_ptr<Chunk>();
+}
 
-    auto chunk = std::make_shared<Chunk>();
+void WorldGenerator::pinChunk(const glm::ivec3& position) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto cacheEntry = chunkCache.find(position);
+    if (cacheEntry != chunkCache.end()) {
+        cacheEntry->second.pins++;
+    }
+}
 
-    // basic world generation
+void WorldGenerator::unpinChunk(const glm::ivec3& position) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto cacheEntry = chunkCache.find(position);
+    // the chunk might have been evicted before it was pinned and generated again since
+    if (cacheEntry != chunkCache.end() && cacheEntry->second.pins > 0) {
+        cacheEntry->second.pins--;
+    }
+}
+
+void WorldGenerator::setMemoryBudget(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    memoryBudget = bytes;
+    evictChunks();
+}
+
+std::size_t WorldGenerator::getMemoryBudget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return memoryBudget;
+}
+
+WorldGenerator::StoreStatistics WorldGenerator::getStoreStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    StoreStatistics statistics = storeStatistics;
+    statistics.trackedEvictions = evictedChunks.size();
+    return statistics;
+}
+
+std::shared_ptr<Chunk> WorldGenerator::storeChunk(const glm::ivec3& position, const std::shared_ptr<Chunk>& chunk, bool generated) {
+    // another thread might have generated the same chunk in the meantime, keep the first one
+    const auto inserted = chunkCache.emplace(position, StoredChunk{chunk, ++accessClock, 0});
+    if (!inserted.second) {
+        return inserted.first->second.chunk;
+    }
+
+    storeStatistics.residentChunks++;
+    storeStatistics.residentBytes += chunkBytes(*chunk);
+    // chunks loaded from the region store after their eviction were not generated again
+    if (evictedChunks.erase(position) != 0 && generated) {
+        storeStatistics.regenerations++;
+    }
+
+    evictChunks();
+    return chunk;
+}
+
+void WorldGenerator::evictChunks() {
+    if (storeStatistics.residentBytes <= memoryBudget) {
+        return;
+    }
+
+    // evict down to 90% of the budget, so the candidates are not collected again for every stored chunk
+    const std::size_t target = memoryBudget / 10 * 9;
+
+    std::vector<std::pair<glm::ivec3, std::uint64_t>> candidates;
+    for (const auto& entry : chunkCache) {
+        if (entry.second.pins == 0) {
+            candidates.emplace_back(entry.first, entry.second.lastAccess);
+        }
+    }
+
+    // chunks outside the focus radius first, furthest first, then the least recently used
+    const glm::ivec3 center = focus;
+    const int radius = focusRadius;
+    std::sort(candidates.begin(), candidates.end(),
+              [&center, radius](const std::pair<glm::ivec3, std::uint64_t>& a, const std::pair<glm::ivec3, std::uint64_t>& b) {
+        const glm::ivec3 da = a.first - center;
+        const glm::ivec3 db = b.first - center;
+        const bool outsideA = std::abs(da.x) > radius || std::abs(da.z) > radius;
+        const bool outsideB = std::abs(db.x) > radius || std::abs(db.z) > radius;
+        if (outsideA != outsideB) {
+            return outsideA;
+        }
+        if (outsideA) {
+            return da.x * da.x + da.z * da.z > db.x * db.x + db.z * db.z;
+        }
+        return a.second < b.second;
+    });
+
+    for (const auto& candidate : candidates) {
+        if (storeStatistics.residentBytes <= target) {
+            break;
+        }
+        auto cacheEntry = chunkCache.find(candidate.first);
+        storeStatistics.residentBytes -= chunkBytes(*cacheEntry->second.chunk);
+        storeStatistics.residentChunks--;
+        storeStatistics.evictions++;
+        evictedChunks[candidate.first] = ++evictionClock;
+        evictionOrder.emplace_back(candidate.first, evictionClock);
+        chunkCache.erase(cacheEntry);
+    }
+
+    // forget the oldest evictions, so the positions do not pile up while the focus moves on
+    while (evictionOrder.size() > std::max<std::size_t>(storeStatistics.residentChunks, 1)) {
+        const auto oldest = evictedChunks.find(evictionOrder.front().first);
+        if (oldest != evictedChunks.end() && oldest->second == evictionOrder.front().second) {
+            evictedChunks.erase(oldest);
+        }
+        evictionOrder.pop_front();
+    }
+}
+
+void WorldGenerator::requestChunk(const glm::ivec3& position) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (chunkCache.count(position) != 0 || !requestedChunks.insert(position).second) {
+            return;
+        }
+        requestQueue.push_back(position);
+        const glm::ivec3 center = focus;
+        std::push_heap(requestQueue.begin(), requestQueue.end(),
+                       [&center](const glm::ivec3& a, const glm::ivec3& b) { return isFurther(center, a, b); });
+    }
+
+    // every request schedules one task, which generates whichever request is nearest when it runs
+    threadPool.submit([this]() { generateNextRequest(); });
+}
+
+void WorldGenerator::setFocus(const glm::ivec3& position, int radius) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (position == focus && radius == focusRadius) {
+        return;
+    }
+    focus = position;
+    focusRadius = radius;
+
+    // cancel the requests which left the radius, their tasks find the queue shorter and return
+    const auto end = std::remove_if(requestQueue.begin(), requestQueue.end(), [&](const glm::ivec3& request) {
+        const bool outside = std::abs(request.x - position.x) > radius || std::abs(request.z - position.z) > radius;
+        if (outside) {
+            requestedChunks.erase(request);
+        }
+        return outside;
+    });
+    requestQueue.erase(end, requestQueue.end());
+    std::make_heap(requestQueue.begin(), requestQueue.end(),
+                   [&position](const glm::ivec3& a, const glm::ivec3& b) { return isFurther(position, a, b); });
+}
+
+std::size_t WorldGenerator::getRequestCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return requestedChunks.size();
+}
+
+void WorldGenerator::generateNextRequest() {
+    glm::ivec3 position;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (requestQueue.empty()) {
+            return;
+        }
+        const glm::ivec3 center = focus;
+        std::pop_heap(requestQueue.begin(), requestQueue.end(),
+                      [&center](const glm::ivec3& a, const glm::ivec3& b) { return isFurther(center, a, b); });
+        position = requestQueue.back();
+        requestQueue.pop_back();
+        if (chunkCache.count(position) != 0) {
+            // generated synchronously in the meantime
+            requestedChunks.erase(position);
+            return;
+        }
+    }
+
+    bool generated = false;
+    const auto chunk = loadOrGenerateChunk(position, generated);
+    addChunk(position, chunk, generated);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    requestedChunks.erase(position);
+}
+
+std::shared_ptr<Chunk> WorldGenerator::generateChunk(const glm::ivec3& position) const {
+    // value initialization fills the chunk with air
+    std::unique_ptr<DenseChunk> chunk(new DenseChunk());
+
+    int heights[CHUNK_SIZE][CHUNK_SIZE];
+    computeHeights(position, heights);
+
+    // layers above the terrain and the water stay air, so the sections above them are not compressed
+    int topLayer = WATER_HEIGHT;
     for (int x = 0; x < CHUNK_SIZE; x++) {
         for (int z = 0; z < CHUNK_SIZE; z++) {
-            const double scaledX = (double(x) / double(CHUNK_SIZE) + double(position.x)) * NOISE_SCALE;
-            const double scaledY = (double(z) / double(CHUNK_SIZE) + double(position.z)) * NOISE_SCALE;
-
-            const double value = noise.octaveNoise0_1(scaledX, scaledY, 8);
+            topLayer = std::max(topLayer, heights[x][z] - 1);
+        }
+    }
+    const int filledSections = std::min(topLayer / SECTION_SIZE + 1, SECTION_COUNT);
 
-            const int height = static_cast<int>(value * CHUNK_HEIGHT);
+    // basic world generation
+    for (int x = 0; x < CHUNK_SIZE; x++) {
+        for (int z = 0; z < CHUNK_SIZE; z++) {
+            const int height = heights[x][z];
             for (int y = 0; y < height; y++) {
                 if (y > CHUNK_HEIGHT * 0.7) {
                     (*chunk)(x, y, z) = TextureAtlas::SNOW;
@@ -32,9 +332,6 @@ std::shared_ptr<Chunk> WorldGenerator::getChunk(const glm::ivec3& position) {
                     (*chunk)(x, y, z) = TextureAtlas::GROUND_EARTH;
                 }
             }
-            for (int y = height; y < CHUNK_HEIGHT; y++) {
-                (*chunk)(x, y, z) = BLOCK_AIR;
-            }
         }
     }
 
@@ -52,6 +349,5 @@ std::shared_ptr<Chunk> WorldGenerator::getChunk(const glm::ivec3& position) {
         }
     }
 
-    chunkCache[position] = chunk;
-    return chunk;
+    return std::make_shared<Chunk>(*chunk, filledSections);
 }
@@ -1,16 +1,71 @@
 #include "voxel/WorldRenderer.h"
+#include "Frustum.h"
 #include "TextureAtlas.h"
 #include "voxel/RenderChunkGenerator.h"
 
 #include <glm/gtx/rotate_vector.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
-const int CAMERA_CHUNK_DISTANCE = 15;
+const std::size_t RENDER_CHUNK_CACHE_BYTES = 128 * 1024 * 1024;
+
+// chunks are culled in square regions of REGION_SIZE x REGION_SIZE chunks first
+const int REGION_SIZE = 8;
+
+// bounds and steps of the adaptive upload budget
+const std::size_t MIN_UPLOAD_BUDGET = 64 * 1024;
+const std::size_t MAX_UPLOAD_BUDGET = 32 * 1024 * 1024;
+const std::size_t UPLOAD_BUDGET_INCREMENT = 64 * 1024;
+// frames up to this much over the target frame time do not count as slow, to tolerate vsync jitter
+const double FRAME_TIME_TOLERANCE = 1.1;
+
+// the solid ground of this many chunks nearest to the camera is rasterized as occluders
+const std::size_t OCCLUDER_CHUNKS = 128;
+
+// the boxes of the occlusion queries are this much larger than the chunks, so they are not hidden by the faces of the
+// chunk itself. Chunks whose query box is this close to the camera are not queried, the near plane could cut it open.
+const float QUERY_BOX_MARGIN = 1.0f / 64.0f;
+const float QUERY_CAMERA_MARGIN = 0.25f;
+
+// a chunk keeps the level of detail of its mesh while it is within this many chunks of the distance range of that level,
+// so chunks near a threshold are not meshed again whenever the camera moves a little
+const float LOD_HYSTERESIS = 1.0f;
+
+// rounds towards negative infinity
+static int floorDiv(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// world space bounds of the layers [minHeight, maxHeight) of the chunks from (x0, z0) to (x1 - 1, z1 - 1).
+// The mesh is scaled down to one unit per chunk and voxels occupy [z - 1, z] along the z axis.
+static Frustum::Containment classifyChunks(const Frustum& frustum, int x0, int z0, int x1, int z1, int minHeight,
+                                           int maxHeight) {
+    const float voxel = 1.0f / float(CHUNK_SIZE);
+    return frustum.classify(glm::vec3(float(x0), 1.0f + float(minHeight) * voxel, float(z0) - voxel),
+                            glm::vec3(float(x1), 1.0f + float(maxHeight) * voxel, float(z1) - voxel));
+}
+
+// world space bounds of the layers of a render chunk which have visible faces
+static void chunkBounds(const glm::ivec3& position, const RenderChunk& renderChunk, glm::vec3& min, glm::vec3& max) {
+    const float voxel = 1.0f / float(CHUNK_SIZE);
+    min = glm::vec3(float(position.x), 1.0f + float(renderChunk.getMinHeight()) * voxel, float(position.z) - voxel);
+    max = glm::vec3(float(position.x + 1), 1.0f + float(renderChunk.getMaxHeight()) * voxel,
+                    float(position.z + 1) - voxel);
+}
+
+// squared horizontal distance from the camera to the center of a chunk
+static float distanceSquared(const glm::ivec3& position, const glm::vec3& cameraPos) {
+    const float dx = float(position.x) + 0.5f - cameraPos.x;
+    const float dz = float(position.z) + 0.5f - cameraPos.z;
+    return dx * dx + dz * dz;
+}
 
 void WorldRenderer::init() {
     texture = std::make_shared<Texture>(Texture::loadFromFile("texture_atlas.gif"));
-    renderChunkGenerator = std::make_shared<RenderChunkGenerator>(1000);
+    renderChunkGenerator = std::make_shared<RenderChunkGenerator>(RENDER_CHUNK_CACHE_BYTES);
+    occlusionQueries = std::make_shared<OcclusionQueries>();
 
     Shader fragmentShader = Shader::loadFromFile("mesh.frag", Shader::Type::Fragment);
     Shader vertexShader = Shader::loadFromFile("mesh.vert", Shader::Type::Vertex);
@@ -19,35 +74,432 @@ void WorldRenderer::init() {
     this->shaderProgram.link();
 }
 
-void WorldRenderer::render(glm::mat4 vp, glm::vec3 cameraPos, glm::vec3 cameraFront, bool wireframe) {
+void WorldRenderer::render(glm::mat4 vp, glm::vec3 cameraPos, bool wireframe) {
     const int currentX = int(cameraPos.x);
     const int currentZ = int(cameraPos.z);
 
+    // generate the chunks nearest to the camera first, drop requests for chunks which are out of reach by now.
+    // The neighbours of the visible chunks are needed for meshing, hence the additional chunk.
+    worldGenerator.setFocus(glm::ivec3(currentX, 1, currentZ), renderDistance + 1);
+
+    const Frustum frustum(vp);
+    cullingStatistics = CullingStatistics();
+
+    const int minX = currentX - renderDistance;
+    const int maxX = currentX + renderDistance;
+    const int minZ = currentZ - renderDistance;
+    const int maxZ = currentZ + renderDistance;
+
+    // create the render chunks the meshing workers finished, within the budget of this frame. The size on screen falls
+    // off with the squared distance, chunks outside the frustum only matter once the camera turns.
+    adjustUploadBudget();
+    const auto importance = [&](const glm::ivec3& position) -> float {
+        if (position.x < minX || position.x >= maxX || position.z < minZ || position.z >= maxZ) {
+            return -1.0f;
+        }
+        const bool visible = classifyChunks(frustum, position.x, position.z, position.x + 1, position.z + 1, 0,
+                                            CHUNK_HEIGHT) != Frustum::Containment::eOutside;
+        return (visible ? 1.0f : 0.1f) / (1.0f + distanceSquared(position, cameraPos));
+    };
+    const auto uploadStart = std::chrono::steady_clock::now();
+    uploadStatistics.uploadedBytes = renderChunkGenerator->uploadMeshedChunks(uploadBudget, importance);
+    uploadStatistics.uploadTime =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+    uploadStatistics.waitingMeshes = renderChunkGenerator->getReadyCount();
+
+    if (caveCulling) {
+        traverseVisibilityGraph(cameraPos, minX, minZ, maxX, maxZ);
+    }
+
+    for (int regionX = floorDiv(minX, REGION_SIZE); regionX <= floorDiv(maxX - 1, REGION_SIZE); regionX++) {
+        for (int regionZ = floorDiv(minZ, REGION_SIZE); regionZ <= floorDiv(maxZ - 1, REGION_SIZE); regionZ++) {
+            const int x0 = std::max(minX, regionX * REGION_SIZE);
+            const int x1 = std::min(maxX, (regionX + 1) * REGION_SIZE);
+            const int z0 = std::max(minZ, regionZ * REGION_SIZE);
+            const int z1 = std::min(maxZ, (regionZ + 1) * REGION_SIZE);
+
+            // a region outside the frustum is skipped as a whole, the chunks of a region inside are not tested
+            cullingStatistics.regionsTested++;
+            const auto regionContainment = classifyChunks(frustum, x0, z0, x1, z1, 0, CHUNK_HEIGHT);
+            if (regionContainment == Frustum::Containment::eOutside) {
+                continue;
+            }
+            cullingStatistics.regionsVisible++;
+
+            for (int x = x0; x < x1; x++) {
+                for (int z = z0; z < z1; z++) {
+                    const auto position = glm::ivec3(x, 1, z);
+                    if (caveCulling && !visibilityGraph.isReachable(x, z)) {
+                        cullingStatistics.chunksCaveCulled++;
+                        continue;
+                    }
+                    if (regionContainment == Frustum::Containment::eIntersecting) {
+                        cullingStatistics.chunksTested++;
+                        if (classifyChunks(frustum, x, z, x + 1, z + 1, 0, CHUNK_HEIGHT) ==
+                            Frustum::Containment::eOutside) {
+                            continue;
+                        }
+                    }
+
+                    // the neighbours' levels decide which borders of the chunk need skirts
+                    const int lod = selectLod(position, cameraPos);
+                    const RenderChunkGenerator::NeighbourLods neighbourLods = {{
+                        selectLod(position + glm::ivec3(1, 0, 0), cameraPos),
+                        selectLod(position + glm::ivec3(-1, 0, 0), cameraPos),
+                        selectLod(position + glm::ivec3(0, 0, 1), cameraPos),
+                        selectLod(position + glm::ivec3(0, 0, -1), cameraPos)}};
+
+                    // chunks which are still being meshed are skipped
+                    const auto renderChunk = renderChunkGenerator->fromChunk(position, lod, neighbourLods, worldGenerator);
+                    if (!renderChunk) {
+                        continue;
+                    }
+
+                    // the layers with visible faces give a tighter box
+                    if (regionContainment == Frustum::Containment::eIntersecting &&
+                        classifyChunks(frustum, x, z, x + 1, z + 1, renderChunk->getMinHeight(),
+                                       renderChunk->getMaxHeight()) == Frustum::Containment::eOutside) {
+                        continue;
+                    }
+                    visibleChunks.emplace_back(position, renderChunk);
+                }
+            }
+        }
+    }
+
+    // front to back, so early depth testing rejects most hidden fragments. The nearest chunks are the occluders.
+    sortVisibleChunks(cameraPos);
+
+    if (occlusionCulling) {
+        cullOccluded(vp);
+    }
+
     this->shaderProgram.use();
     this->texture->bind();
+    for (const auto& visibleChunk : visibleChunks) {
+        // the box of every chunk in view is queried again, the chunk is skipped while its latest result is hidden
+        if (occlusionQueryCulling) {
+            glm::vec3 min;
+            glm::vec3 max;
+            chunkBounds(visibleChunk.first, *visibleChunk.second, min, max);
+            min -= glm::vec3(QUERY_BOX_MARGIN);
+            max += glm::vec3(QUERY_BOX_MARGIN);
+            const glm::vec3 nearMin = min - glm::vec3(QUERY_CAMERA_MARGIN);
+            const glm::vec3 nearMax = max + glm::vec3(QUERY_CAMERA_MARGIN);
+            const bool nearCamera = cameraPos.x > nearMin.x && cameraPos.x < nearMax.x && cameraPos.y > nearMin.y &&
+                                    cameraPos.y < nearMax.y && cameraPos.z > nearMin.z && cameraPos.z < nearMax.z;
+            if (!nearCamera) {
+                const bool hidden = occlusionQueries->isOccluded(visibleChunk.first);
+                occlusionQueries->queue(visibleChunk.first, min, max);
+                if (hidden) {
+                    cullingStatistics.chunksQueryOccluded++;
+                    continue;
+                }
+            }
+        }
+        cullingStatistics.chunksVisible++;
+        cullingStatistics.chunksPerLod[visibleChunk.second->getLod()]++;
+        visibleChunk.second->queueDraw(glm::vec3(visibleChunk.first));
+    }
+    visibleChunks.clear();
 
-    for (int x = currentX - CAMERA_CHUNK_DISTANCE; x < currentX + CAMERA_CHUNK_DISTANCE; x++) {
-        for (int z = currentZ - CAMERA_CHUNK_DISTANCE; z < currentZ + CAMERA_CHUNK_DISTANCE; z++) {
-            const auto position = glm::ivec3(x, 1, z);
-            const auto floatPosition = glm::vec3(position);
-
-            // check if current chunk is behind the camera, if yes, skip rendering it
-            // vector from camera position to current block position
-            const glm::vec3 cameraRelativeVector = floatPosition - cameraPos;
-            // if dot product is smaller than 0.0 (angle between the two vectors is greater than perpendicular),
-            // block is behind the camera
-            if (glm::dot(cameraRelativeVector, cameraFront) < 0.0f) {
-                continue;
+    this->shaderProgram.setUniform("vp", vp);
+    renderChunkGenerator->drawQueued(wireframe);
+
+    // tested against the depth of this frame, the results decide about the next frames
+    occlusionQueries->issueQueued(vp);
+}
+
+// finds the chunks reachable from the camera through connected air. Chunks which are not meshed yet count as open.
+void WorldRenderer::traverseVisibilityGraph(const glm::vec3& cameraPos, int minX, int minZ, int maxX, int maxZ) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // every section is one unit high, voxels occupy [z - 1, z] along the z axis
+    const glm::ivec3 cameraSection(int(std::floor(cameraPos.x)), int(std::floor(cameraPos.y - 1.0f)),
+                                   int(std::floor(cameraPos.z + 1.0f / float(CHUNK_SIZE))));
+    VisibilityGraph::ChunkConnectivity open;
+    open.fill(VisibilityGraph::k_uiAllConnected);
+    visibilityGraph.traverse(cameraSection, minX, minZ, maxX, maxZ, [&](const glm::ivec3& position) {
+        const auto renderChunk = renderChunkGenerator->findRenderChunk(position);
+        return renderChunk ? renderChunk->getConnectivity() : open;
+    });
+
+    cullingStatistics.sectionsTraversed = visibilityGraph.getStatistics().uiVisitedSections;
+    cullingStatistics.caveCullingTime =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// sorts the visible chunks by their distance to the camera, quantized to 1/256 chunk, with a stable radix sort of one
+// pass per byte of the distance
+void WorldRenderer::sortVisibleChunks(const glm::vec3& cameraPos) {
+    const auto start = std::chrono::steady_clock::now();
+
+    sortKeys.resize(visibleChunks.size());
+    sortedKeys.resize(visibleChunks.size());
+    sortedChunks.resize(visibleChunks.size());
+    for (std::size_t i = 0; i < visibleChunks.size(); i++) {
+        const float distance = std::sqrt(distanceSquared(visibleChunks[i].first, cameraPos));
+        sortKeys[i] = std::uint16_t(std::min(65535.0f, distance * 256.0f));
+    }
+
+    for (int shift = 0; shift < 16; shift += 8) {
+        // offsets[digit + 1] counts the keys with that digit, then the prefix sums give the first index per digit
+        std::size_t offsets[257] = {};
+        for (const std::uint16_t key : sortKeys) {
+            offsets[((key >> shift) & 0xFF) + 1]++;
+        }
+        for (std::size_t digit = 1; digit < 257; digit++) {
+            offsets[digit] += offsets[digit - 1];
+        }
+        for (std::size_t i = 0; i < visibleChunks.size(); i++) {
+            const std::size_t target = offsets[(sortKeys[i] >> shift) & 0xFF]++;
+            sortedKeys[target] = sortKeys[i];
+            sortedChunks[target] = std::move(visibleChunks[i]);
+        }
+        sortKeys.swap(sortedKeys);
+        visibleChunks.swap(sortedChunks);
+    }
+    sortedChunks.clear();
+
+    cullingStatistics.sortTime =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// rasterizes the solid ground of the nearest visible chunks, which come first, and removes the visible chunks hidden
+// behind it
+void WorldRenderer::cullOccluded(const glm::mat4& vp) {
+    const auto start = std::chrono::steady_clock::now();
+
+    // every occluder cell is a box from the bottom of the chunk up to the height all of its columns are solid to
+    const float voxel = 1.0f / float(CHUNK_SIZE);
+    const float cellSize = 1.0f / float(RenderChunk::k_iOccluderCells);
+    occlusionCuller.begin(vp);
+    for (std::size_t i = 0; i < std::min(OCCLUDER_CHUNKS, visibleChunks.size()); i++) {
+        const glm::ivec3& position = visibleChunks[i].first;
+        for (int cellX = 0; cellX < RenderChunk::k_iOccluderCells; cellX++) {
+            for (int cellZ = 0; cellZ < RenderChunk::k_iOccluderCells; cellZ++) {
+                const int height = visibleChunks[i].second->getOccluderHeight(cellX, cellZ);
+                if (height == 0) {
+                    continue;
+                }
+                const glm::vec3 min(float(position.x) + float(cellX) * cellSize, 1.0f,
+                                    float(position.z) + float(cellZ) * cellSize - voxel);
+                occlusionCuller.addOccluder(min, min + glm::vec3(cellSize, float(height) * voxel, cellSize));
             }
+        }
+    }
+    occlusionCuller.finishOccluders();
+
+    // the layers with visible faces give the box of a chunk, the occluders of a chunk never hide the chunk itself
+    const auto occluded = [&](const std::pair<glm::ivec3, std::shared_ptr<RenderChunk>>& visibleChunk) {
+        glm::vec3 min;
+        glm::vec3 max;
+        chunkBounds(visibleChunk.first, *visibleChunk.second, min, max);
+        return occlusionCuller.isOccluded(min, max);
+    };
+    const auto end = std::remove_if(visibleChunks.begin(), visibleChunks.end(), occluded);
+    cullingStatistics.chunksOccluded = std::size_t(visibleChunks.end() - end);
+    visibleChunks.erase(end, visibleChunks.end());
+
+    cullingStatistics.occluderTriangles = occlusionCuller.getTriangleCount();
+    cullingStatistics.occlusionTime =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// level of detail for a chunk at the given horizontal distance from the camera
+int WorldRenderer::lodForDistance(float distance) const {
+    int lod = 0;
+    for (float threshold = float(lodDistance); distance >= threshold && lod < RenderChunkGenerator::k_iLodCount - 1;
+         threshold *= 2.0f) {
+        lod++;
+    }
+    return lod;
+}
 
-            auto chunk = worldGenerator.getChunk(position);
-            const auto renderChunk = renderChunkGenerator->fromChunk(position, (*chunk), worldGenerator);
+// level of detail a chunk is drawn at. A cached mesh keeps its level until the distance is clearly beyond the
+// threshold, so chunks near a threshold are not meshed again whenever the camera moves a little.
+int WorldRenderer::selectLod(const glm::ivec3& position, const glm::vec3& cameraPos) const {
+    if (!levelOfDetail) {
+        return 0;
+    }
+    const float distance = std::sqrt(distanceSquared(position, cameraPos));
+    const auto cached = renderChunkGenerator->findRenderChunk(position);
+    if (cached && cached->getLod() >= lodForDistance(distance - LOD_HYSTERESIS) &&
+        cached->getLod() <= lodForDistance(distance + LOD_HYSTERESIS)) {
+        return cached->getLod();
+    }
+    return lodForDistance(distance);
+}
 
-            glm::mat4 modelMatrix = glm::mat4(1.0f);
-            modelMatrix = glm::translate(modelMatrix, glm::vec3(floatPosition));
-            auto mvp = vp * modelMatrix;
-            this->shaderProgram.setUniform("mvp", mvp);
-            renderChunk->render(wireframe);
+// measures the time since the previous frame and adapts the upload budget to it
+void WorldRenderer::adjustUploadBudget() {
+    const auto now = std::chrono::steady_clock::now();
+    const bool firstFrame = lastFrame == std::chrono::steady_clock::time_point();
+    uploadStatistics.frameTime = firstFrame ? 0.0 : std::chrono::duration<double, std::milli>(now - lastFrame).count();
+    lastFrame = now;
+
+    if (adaptiveUploadBudget && !firstFrame) {
+        if (uploadStatistics.frameTime > targetFrameTime * FRAME_TIME_TOLERANCE) {
+            uploadBudget = std::max(MIN_UPLOAD_BUDGET, uploadBudget / 2);
+        } else {
+            uploadBudget = std::min(MAX_UPLOAD_BUDGET, uploadBudget + UPLOAD_BUDGET_INCREMENT);
         }
     }
+    uploadStatistics.budgetBytes = uploadBudget;
+}
+
+void WorldRenderer::setMeshingMode(RenderChunkGenerator::MeshingMode meshingMode) {
+    renderChunkGenerator->setMeshingMode(meshingMode);
+}
+
+RenderChunkGenerator::MeshingMode WorldRenderer::getMeshingMode() const {
+    return renderChunkGenerator->getMeshingMode();
+}
+
+const RenderChunkGenerator::Statistics& WorldRenderer::getMeshingStatistics() const {
+    return renderChunkGenerator->getStatistics();
+}
+
+std::size_t WorldRenderer::getPendingMeshCount() const {
+    return renderChunkGenerator->getPendingCount();
+}
+
+const LimitedUnorderedMap<glm::ivec3, RenderChunk>::Statistics& WorldRenderer::getMeshCacheStatistics() const {
+    return renderChunkGenerator->getCacheStatistics();
+}
+
+std::size_t WorldRenderer::getCachedMeshCount() const {
+    return renderChunkGenerator->getCachedChunkCount();
+}
+
+std::size_t WorldRenderer::getCachedMeshBytes() const {
+    return renderChunkGenerator->getCachedBytes();
+}
+
+const WorldRenderer::CullingStatistics& WorldRenderer::getCullingStatistics() const {
+    return cullingStatistics;
+}
+
+void WorldRenderer::setCaveCulling(bool enabled) {
+    caveCulling = enabled;
+}
+
+bool WorldRenderer::isCaveCullingEnabled() const {
+    return caveCulling;
+}
+
+void WorldRenderer::setOcclusionCulling(bool enabled) {
+    occlusionCulling = enabled;
+}
+
+bool WorldRenderer::isOcclusionCullingEnabled() const {
+    return occlusionCulling;
+}
+
+void WorldRenderer::setOcclusionQueryCulling(bool enabled) {
+    occlusionQueryCulling = enabled;
+}
+
+bool WorldRenderer::isOcclusionQueryCullingEnabled() const {
+    return occlusionQueryCulling;
+}
+
+const OcclusionQueries::Statistics& WorldRenderer::getOcclusionQueryStatistics() const {
+    return occlusionQueries->getStatistics();
+}
+
+void WorldRenderer::setLevelOfDetail(bool enabled) {
+    levelOfDetail = enabled;
+}
+
+bool WorldRenderer::isLevelOfDetailEnabled() const {
+    return levelOfDetail;
+}
+
+void WorldRenderer::setLodDistance(int chunks) {
+    lodDistance = std::max(1, chunks);
+}
+
+int WorldRenderer::getLodDistance() const {
+    return lodDistance;
+}
+
+const VertexArena& WorldRenderer::getVertexArena() const {
+    return renderChunkGenerator->getArena();
+}
+
+void WorldRenderer::setRenderDistance(int chunks) {
+    renderDistance = std::max(MIN_RENDER_DISTANCE, std::min(MAX_RENDER_DISTANCE, chunks));
+}
+
+int WorldRenderer::getRenderDistance() const {
+    return renderDistance;
+}
+
+void WorldRenderer::setUploadBudget(std::size_t bytes) {
+    uploadBudget = std::max(MIN_UPLOAD_BUDGET, std::min(MAX_UPLOAD_BUDGET, bytes));
+}
+
+std::size_t WorldRenderer::getUploadBudget() const {
+    return uploadBudget;
+}
+
+void WorldRenderer::setAdaptiveUploadBudget(bool enabled) {
+    adaptiveUploadBudget = enabled;
+}
+
+bool WorldRenderer::isAdaptiveUploadBudget() const {
+    return adaptiveUploadBudget;
+}
+
+void WorldRenderer::setTargetFrameTime(double milliseconds) {
+    targetFrameTime = milliseconds;
+}
+
+double WorldRenderer::getTargetFrameTime() const {
+    return targetFrameTime;
+}
+
+const WorldRenderer::UploadStatistics& WorldRenderer::getUploadStatistics() const {
+    return uploadStatistics;
+}
+
+std::size_t WorldRenderer::getPendingChunkCount() const {
+    return worldGenerator.getRequestCount();
+}
+
+void WorldRenderer::setSimdNoise(bool enabled) {
+    worldGenerator.setSimdNoise(enabled);
+}
+
+bool WorldRenderer::isSimdNoiseActive() const {
+    return worldGenerator.isSimdNoiseActive();
+}
+
+double WorldRenderer::getNoiseSamplesPerSecond() const {
+    return worldGenerator.getNoiseSamplesPerSecond();
+}
+
+void WorldRenderer::setChunkMemoryBudget(std::size_t bytes) {
+    worldGenerator.setMemoryBudget(bytes);
+}
+
+std::size_t WorldRenderer::getChunkMemoryBudget() const {
+    return worldGenerator.getMemoryBudget();
+}
+
+WorldGenerator::StoreStatistics WorldRenderer::getChunkStoreStatistics() const {
+    return worldGenerator.getStoreStatistics();
+}
+
+void WorldRenderer::setChunkPersistence(bool enabled) {
+    worldGenerator.setPersistence(enabled);
+}
+
+bool WorldRenderer::isChunkPersistenceEnabled() const {
+    return worldGenerator.isPersistenceEnabled();
+}
+
+RegionStore::Statistics WorldRenderer::getRegionStatistics() const {
+    return worldGenerator.getRegionStore().getStatistics();
 }
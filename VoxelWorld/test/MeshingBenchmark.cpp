@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "Vertex.h"
+#include "voxel/ChunkMesher.h"
+#include "voxel/MeshingContext.h"
+#include "voxel/WorldGenerator.h"
+
+
+/** Chunks along x and z of the meshed square */
+static const int k_iChunks = 8;
+
+/** Times every chunk is meshed per mode, the timings are averaged */
+static const int k_iRepetitions = 10;
+
+using Quad = std::array<std::uint32_t, 4>;
+
+/**
+ * Turns a mesh into the sorted list of its quads, each with its packed vertices sorted, so that meshes emitting the same
+ * quads in another order compare equal
+ */
+static std::vector<Quad> sortedQuads(const std::vector<PackedVertex>& vecVertices)
+{
+	std::vector<Quad> vecQuads;
+	vecQuads.reserve(vecVertices.size() / 4);
+	for (std::size_t i = 0; i + 3 < vecVertices.size(); i += 4)
+	{
+		Quad arrQuad = {{vecVertices[i].data, vecVertices[i + 1].data, vecVertices[i + 2].data, vecVertices[i + 3].data}};
+		std::sort(arrQuad.begin(), arrQuad.end());
+		vecQuads.push_back(arrQuad);
+	}
+	std::sort(vecQuads.begin(), vecQuads.end());
+	return vecQuads;
+}
+
+/**
+ * Meshes a fixed square of generated chunks with every meshing mode without a GL context, reports the meshing time per
+ * chunk and checks that the binary mesher emits exactly the quads of the naive one.
+ *
+ * @return EXIT_FAILURE if the quads of the binary and the naive mesher differ for any chunk
+ */
+int main()
+{
+	WorldGenerator xWorldGenerator;
+	xWorldGenerator.setPersistence(false);
+
+	// the chunks are generated up front, so only the meshing is timed
+	std::vector<std::unique_ptr<MeshingContext>> vecContexts;
+	for (int x = 0; x < k_iChunks; x++)
+	{
+		for (int z = 0; z < k_iChunks; z++)
+		{
+			const glm::ivec3 xPosition(x, 1, z);
+			vecContexts.emplace_back(new MeshingContext(*xWorldGenerator.getChunk(xPosition),
+			                                            *xWorldGenerator.getChunk(xPosition + glm::ivec3(-1, 0, 0)),
+			                                            *xWorldGenerator.getChunk(xPosition + glm::ivec3(1, 0, 0)),
+			                                            *xWorldGenerator.getChunk(xPosition + glm::ivec3(0, 0, -1)),
+			                                            *xWorldGenerator.getChunk(xPosition + glm::ivec3(0, 0, 1))));
+		}
+	}
+
+	const std::array<ChunkMesher::MeshingMode, 3> arrModes = {
+		{ChunkMesher::MeshingMode::eNaive, ChunkMesher::MeshingMode::eGreedy, ChunkMesher::MeshingMode::eBinary}};
+	const std::array<const char*, 3> arrNames = {{"naive", "greedy", "binary"}};
+
+	// meshes of the last repetition, per mode and chunk
+	std::array<std::vector<std::vector<PackedVertex>>, 3> arrMeshes;
+	std::printf("%d chunks, %d repetitions\n", k_iChunks * k_iChunks, k_iRepetitions);
+	for (std::size_t m = 0; m < arrModes.size(); m++)
+	{
+		arrMeshes[m].resize(vecContexts.size());
+		std::uint64_t uiVertices = 0;
+		const auto xStart = std::chrono::steady_clock::now();
+		for (int r = 0; r < k_iRepetitions; r++)
+		{
+			for (std::size_t c = 0; c < vecContexts.size(); c++)
+			{
+				std::vector<PackedVertex>& vecVertices = arrMeshes[m][c];
+				vecVertices.clear();
+				ChunkMesher::meshChunk(vecVertices, *vecContexts[c], arrModes[m]);
+				uiVertices += vecVertices.size();
+			}
+		}
+		const std::chrono::duration<double, std::milli> xElapsed = std::chrono::steady_clock::now() - xStart;
+		const double dChunks = static_cast<double>(vecContexts.size()) * k_iRepetitions;
+		std::printf("%-6s  %8.3f ms/chunk  %10.1f vertices/chunk\n", arrNames[m], xElapsed.count() / dChunks,
+		            static_cast<double>(uiVertices) / dChunks);
+	}
+
+	std::size_t uiMismatches = 0;
+	for (std::size_t c = 0; c < vecContexts.size(); c++)
+	{
+		if (sortedQuads(arrMeshes[0][c]) != sortedQuads(arrMeshes[2][c]))
+		{
+			uiMismatches++;
+		}
+	}
+	if (uiMismatches > 0)
+	{
+		std::printf("FAILED: binary and naive quads differ for %zu of %zu chunks\n", uiMismatches, vecContexts.size());
+		return EXIT_FAILURE;
+	}
+	std::printf("binary and naive quads match for all %zu chunks\n", vecContexts.size());
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "BatchedPerlinNoise.h"
+#include "PerlinNoise.h"
+
+
+/** Sample points along each axis of the grid, 32 chunks of 16 columns centred on the origin */
+static const int k_iGridSize = 512;
+
+/** Distance between neighbouring sample points, the spacing of the columns in WorldGenerator */
+static const double k_dSpacing = 0.1 / 16.0;
+
+/** Octaves of the terrain noise */
+static const std::int32_t k_iOctaves = 8;
+
+/** Times the grid is evaluated per implementation, the fastest run is reported */
+static const int k_iRepetitions = 3;
+
+/**
+ * Evaluates the grid with the given noise and returns the fastest of k_iRepetitions runs [seconds]
+ */
+static double timeNoise(const BatchedPerlinNoise& xNoise, const std::vector<double>& vecX, const std::vector<double>& vecY,
+                        std::vector<double>& vecResult)
+{
+	double dBest = 0.0;
+	for (int r = 0; r < k_iRepetitions; r++)
+	{
+		const auto xStart = std::chrono::steady_clock::now();
+		xNoise.octaveNoise0_1(vecX.data(), vecY.data(), vecResult.data(), vecResult.size(), k_iOctaves);
+		const std::chrono::duration<double> xElapsed = std::chrono::steady_clock::now() - xStart;
+		dBest = r == 0 ? xElapsed.count() : std::min(dBest, xElapsed.count());
+	}
+	return dBest;
+}
+
+/**
+ * @return largest difference between the values and the reference values
+ */
+static double maxDifference(const std::vector<double>& vecValues, const std::vector<double>& vecReference)
+{
+	double dMax = 0.0;
+	for (std::size_t i = 0; i < vecValues.size(); i++)
+	{
+		dMax = std::max(dMax, std::fabs(vecValues[i] - vecReference[i]));
+	}
+	return dMax;
+}
+
+/**
+ * Times the scalar and the AVX2 implementation of BatchedPerlinNoise over a fixed grid of terrain samples and checks
+ * both against siv::PerlinNoise::octaveNoise0_1. The AVX2 implementation is skipped on CPUs without AVX2.
+ *
+ * @return EXIT_FAILURE if an implementation differs from the reference by more than BatchedPerlinNoise::k_dTolerance
+ */
+int main()
+{
+	const std::size_t uiSamples = static_cast<std::size_t>(k_iGridSize) * k_iGridSize;
+	std::vector<double> vecX(uiSamples);
+	std::vector<double> vecY(uiSamples);
+	for (int i = 0; i < k_iGridSize; i++)
+	{
+		for (int j = 0; j < k_iGridSize; j++)
+		{
+			const std::size_t uiIndex = static_cast<std::size_t>(i * k_iGridSize + j);
+			vecX[uiIndex] = (i - k_iGridSize / 2) * k_dSpacing;
+			vecY[uiIndex] = (j - k_iGridSize / 2) * k_dSpacing;
+		}
+	}
+
+	const siv::PerlinNoise xReference(1);
+	std::vector<double> vecReference(uiSamples);
+	for (std::size_t i = 0; i < uiSamples; i++)
+	{
+		vecReference[i] = xReference.octaveNoise0_1(vecX[i], vecY[i], k_iOctaves);
+	}
+
+	BatchedPerlinNoise xNoise(1);
+	std::vector<double> vecResult(uiSamples);
+	bool bFailed = false;
+	std::printf("%zu samples, %d octaves\n", uiSamples, k_iOctaves);
+
+	xNoise.setSimdEnabled(false);
+	const double dScalarTime = timeNoise(xNoise, vecX, vecY, vecResult);
+	const double dScalarDifference = maxDifference(vecResult, vecReference);
+	std::printf("scalar  %8.2f Msamples/s  max difference %g\n", static_cast<double>(uiSamples) / dScalarTime / 1e6,
+	            dScalarDifference);
+	bFailed |= dScalarDifference > BatchedPerlinNoise::k_dTolerance;
+
+	xNoise.setSimdEnabled(true);
+	if (xNoise.isSimdActive())
+	{
+		const double dSimdTime = timeNoise(xNoise, vecX, vecY, vecResult);
+		const double dSimdDifference = maxDifference(vecResult, vecReference);
+		std::printf("avx2    %8.2f Msamples/s  max difference %g  speedup %.2fx\n",
+		            static_cast<double>(uiSamples) / dSimdTime / 1e6, dSimdDifference, dScalarTime / dSimdTime);
+		bFailed |= dSimdDifference > BatchedPerlinNoise::k_dTolerance;
+	}
+	else
+	{
+		std::printf("avx2    not supported, skipped\n");
+	}
+
+	if (bFailed)
+	{
+		std::printf("FAILED: difference to siv::PerlinNoise exceeds %g\n", BatchedPerlinNoise::k_dTolerance);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+#include "OcclusionCuller.h"
+
+
+/** Number of random scenes */
+static const int k_iScenes = 200;
+
+/** Occluders per scene */
+static const int k_iOccluders = 120;
+
+/** Boxes tested per scene */
+static const int k_iTestedBoxes = 100;
+
+/** Ray targets along each edge of a face of a tested box */
+static const int k_iSamplesPerEdge = 8;
+
+/** Half the size of the cube around the origin the boxes are placed in */
+static const float k_fSceneSize = 24.0f;
+
+/** Distance of the near plane, the camera is kept at least this far from the occluders */
+static const float k_fNearPlane = 0.1f;
+
+/**
+ * Axis aligned box in world coordinates
+ */
+struct Box
+{
+	glm::vec3 xMin;
+	glm::vec3 xMax;
+};
+
+/**
+ * Tests whether the segment from xOrigin to xOrigin + xDirection enters the box before its end. Targets on the surface
+ * of the box itself do not count as hidden by it.
+ */
+static bool hitsBox(const glm::vec3& xOrigin, const glm::vec3& xDirection, const Box& xBox)
+{
+	float fEnter = 0.0f;
+	float fExit = 1.0f;
+	for (int i = 0; i < 3; i++)
+	{
+		if (xDirection[i] == 0.0f)
+		{
+			if (xOrigin[i] < xBox.xMin[i] || xOrigin[i] > xBox.xMax[i])
+			{
+				return false;
+			}
+			continue;
+		}
+		float fNear = (xBox.xMin[i] - xOrigin[i]) / xDirection[i];
+		float fFar = (xBox.xMax[i] - xOrigin[i]) / xDirection[i];
+		if (fNear > fFar)
+		{
+			std::swap(fNear, fFar);
+		}
+		fEnter = std::max(fEnter, fNear);
+		fExit = std::min(fExit, fFar);
+		if (fEnter > fExit)
+		{
+			return false;
+		}
+	}
+	return fEnter < 1.0f - 1.0e-4f;
+}
+
+/**
+ * Looks for a point on the surface of the box inside the view frustum which can be seen from the camera, by casting a
+ * ray to a grid of points on every face of the box
+ *
+ * @return whether any such point was found
+ */
+static bool isVisible(const Box& xBox, const glm::vec3& xEye, const glm::mat4& xViewProjection,
+                      const std::vector<Box>& vecOccluders)
+{
+	for (int iAxis = 0; iAxis < 3; iAxis++)
+	{
+		for (int iSide = 0; iSide < 2; iSide++)
+		{
+			for (int a = 0; a < k_iSamplesPerEdge; a++)
+			{
+				for (int b = 0; b < k_iSamplesPerEdge; b++)
+				{
+					const float fA = static_cast<float>(a) / (k_iSamplesPerEdge - 1);
+					const float fB = static_cast<float>(b) / (k_iSamplesPerEdge - 1);
+					const int iU = (iAxis + 1) % 3;
+					const int iV = (iAxis + 2) % 3;
+					glm::vec3 xTarget;
+					xTarget[iAxis] = iSide ? xBox.xMax[iAxis] : xBox.xMin[iAxis];
+					xTarget[iU] = xBox.xMin[iU] + (xBox.xMax[iU] - xBox.xMin[iU]) * fA;
+					xTarget[iV] = xBox.xMin[iV] + (xBox.xMax[iV] - xBox.xMin[iV]) * fB;
+
+					const glm::vec4 xClip = xViewProjection * glm::vec4(xTarget, 1.0f);
+					if (xClip.w <= 0.0f || std::fabs(xClip.x) > xClip.w || std::fabs(xClip.y) > xClip.w ||
+					    std::fabs(xClip.z) > xClip.w)
+					{
+						continue;
+					}
+					bool bHidden = false;
+					for (const Box& xOccluder : vecOccluders)
+					{
+						if (hitsBox(xEye, xTarget - xEye, xOccluder))
+						{
+							bHidden = true;
+							break;
+						}
+					}
+					if (!bHidden)
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+/**
+ * Fills random scenes with solid boxes, tests random boxes against them with OcclusionCuller and checks every box
+ * reported occluded by casting rays from the camera to its surface. No GL context is needed.
+ *
+ * @return EXIT_FAILURE if a box with a visible point was reported occluded, or no box was occluded at all
+ */
+int main()
+{
+	std::mt19937 xRandom(1);
+	std::uniform_real_distribution<float> xPosition(-k_fSceneSize, k_fSceneSize);
+	std::uniform_real_distribution<float> xOccluderSize(1.0f, 12.0f);
+	std::uniform_real_distribution<float> xBoxSize(0.2f, 3.0f);
+	std::uniform_real_distribution<float> xAngle(-3.14159265f, 3.14159265f);
+	std::uniform_real_distribution<float> xPitch(-0.6f, 0.6f);
+
+	OcclusionCuller xCuller;
+	std::vector<Box> vecOccluders;
+	int iTested = 0;
+	int iOccluded = 0;
+	int iFailures = 0;
+	for (int s = 0; s < k_iScenes; s++)
+	{
+		const glm::vec3 xEye(xPosition(xRandom) * 0.25f, xPosition(xRandom) * 0.25f, xPosition(xRandom) * 0.25f);
+		const float fYaw = xAngle(xRandom);
+		const float fPitch = xPitch(xRandom);
+		const glm::vec3 xFront(std::cos(fPitch) * std::sin(fYaw), std::sin(fPitch), std::cos(fPitch) * std::cos(fYaw));
+		const glm::mat4 xViewProjection =
+			glm::perspective(glm::radians(70.0f), static_cast<float>(OcclusionCuller::k_iWidth) / OcclusionCuller::k_iHeight,
+			                 k_fNearPlane, 500.0f) *
+			glm::lookAt(xEye, xEye + xFront, glm::vec3(0.0f, 1.0f, 0.0f));
+
+		vecOccluders.clear();
+		while (static_cast<int>(vecOccluders.size()) < k_iOccluders)
+		{
+			const glm::vec3 xMin(xPosition(xRandom), xPosition(xRandom), xPosition(xRandom));
+			const Box xOccluder = {xMin, xMin + glm::vec3(xOccluderSize(xRandom), xOccluderSize(xRandom), xOccluderSize(xRandom))};
+			// the camera must not be inside an occluder or closer to it than the near plane
+			const glm::vec3 xNearest = glm::max(xOccluder.xMin, glm::min(xEye, xOccluder.xMax));
+			if (glm::length(xNearest - xEye) > k_fNearPlane * 2.0f)
+			{
+				vecOccluders.push_back(xOccluder);
+			}
+		}
+
+		xCuller.begin(xViewProjection);
+		for (const Box& xOccluder : vecOccluders)
+		{
+			xCuller.addOccluder(xOccluder.xMin, xOccluder.xMax);
+		}
+		xCuller.finishOccluders();
+
+		for (int i = 0; i < k_iTestedBoxes; i++)
+		{
+			const glm::vec3 xMin(xPosition(xRandom), xPosition(xRandom), xPosition(xRandom));
+			const Box xBox = {xMin, xMin + glm::vec3(xBoxSize(xRandom), xBoxSize(xRandom), xBoxSize(xRandom))};
+			iTested++;
+			if (!xCuller.isOccluded(xBox.xMin, xBox.xMax))
+			{
+				continue;
+			}
+			iOccluded++;
+			if (isVisible(xBox, xEye, xViewProjection, vecOccluders))
+			{
+				iFailures++;
+				std::printf("visible box reported occluded: scene %d, box (%g, %g, %g) - (%g, %g, %g)\n", s,
+				            static_cast<double>(xBox.xMin.x), static_cast<double>(xBox.xMin.y),
+				            static_cast<double>(xBox.xMin.z), static_cast<double>(xBox.xMax.x),
+				            static_cast<double>(xBox.xMax.y), static_cast<double>(xBox.xMax.z));
+			}
+		}
+	}
+
+	std::printf("%d boxes tested, %d occluded, %d of them visible\n", iTested, iOccluded, iFailures);
+	if (iFailures > 0)
+	{
+		std::printf("FAILED: visible boxes were reported occluded\n");
+		return EXIT_FAILURE;
+	}
+	if (iOccluded == 0)
+	{
+		std::printf("FAILED: no box was occluded, the scenes do not exercise the culler\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
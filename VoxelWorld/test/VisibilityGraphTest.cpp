@@ -0,0 +1,211 @@
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+
+#include <glm/vec3.hpp>
+
+#include "voxel/VisibilityGraph.h"
+#include "voxel/WorldGenerator.h"
+
+
+/** Chunks along x and z of the traversed rectangle, centred on the origin */
+static const int k_iWorldRadius = 6;
+
+/** Number of failed checks */
+static int s_iFailures = 0;
+
+/**
+ * Reports a failed check
+ */
+static void check(const bool bCondition, const char* pDescription)
+{
+	if (!bCondition)
+	{
+		s_iFailures++;
+		std::printf("FAILED: %s\n", pDescription);
+	}
+}
+
+/**
+ * Builds a chunk whose voxels are solid where the predicate holds
+ */
+static Chunk makeChunk(const std::function<bool(int, int, int)>& fnSolid)
+{
+	std::unique_ptr<DenseChunk> pDense(new DenseChunk());
+	for (int x = 0; x < CHUNK_SIZE; x++)
+	{
+		for (int y = 0; y < CHUNK_HEIGHT; y++)
+		{
+			for (int z = 0; z < CHUNK_SIZE; z++)
+			{
+				(*pDense)(x, y, z) = fnSolid(x, y, z) ? 1 : BLOCK_AIR;
+			}
+		}
+	}
+	return Chunk(*pDense);
+}
+
+/**
+ * Traverses a rectangle of identical chunks around the origin
+ */
+static void traverse(VisibilityGraph& xGraph, const glm::ivec3& xCameraSection,
+                     const VisibilityGraph::ChunkConnectivity& arrConnectivity)
+{
+	xGraph.traverse(xCameraSection, -k_iWorldRadius, -k_iWorldRadius, k_iWorldRadius, k_iWorldRadius,
+	                [&arrConnectivity](const glm::ivec3&) { return arrConnectivity; });
+}
+
+/**
+ * The 15 pairs of faces map to distinct bits, numbered by their lower face first, and the relation is symmetric
+ */
+static void testPairBits()
+{
+	int iExpectedBit = 0;
+	for (int iFaceA = 0; iFaceA < 6; iFaceA++)
+	{
+		for (int iFaceB = iFaceA + 1; iFaceB < 6; iFaceB++)
+		{
+			const auto uiBit = static_cast<VisibilityGraph::Connectivity>(1 << iExpectedBit);
+			for (int iOtherA = 0; iOtherA < 6; iOtherA++)
+			{
+				for (int iOtherB = 0; iOtherB < 6; iOtherB++)
+				{
+					if (iOtherA == iOtherB)
+					{
+						continue;
+					}
+					const bool bSamePair = (iOtherA == iFaceA && iOtherB == iFaceB) || (iOtherA == iFaceB && iOtherB == iFaceA);
+					check(VisibilityGraph::isConnected(uiBit, iOtherA, iOtherB) == bSamePair,
+					      "every pair of faces has its own bit in the order of the lower face");
+				}
+			}
+			check(VisibilityGraph::isConnected(VisibilityGraph::k_uiAllConnected, iFaceA, iFaceB),
+			      "k_uiAllConnected connects every pair of faces");
+			iExpectedBit++;
+		}
+	}
+	check(iExpectedBit == 15 && VisibilityGraph::k_uiAllConnected == (1 << iExpectedBit) - 1,
+	      "k_uiAllConnected holds exactly the bits of the 15 pairs");
+}
+
+/**
+ * Air enclosed within a section connects no faces, neither does air touching a single face. Uniform sections are all
+ * or nothing.
+ */
+static void testSealedSection()
+{
+	// section 0 solid, section 1 a pocket of air inside, section 2 a dent in its top face, section 3 air
+	const Chunk xChunk = makeChunk([](const int x, const int y, const int z) {
+		const bool bPocket = y >= 20 && y < 28 && x >= 4 && x < 12 && z >= 4 && z < 12;
+		const bool bDent = y >= 40 && y < 48 && x >= 4 && x < 12 && z >= 4 && z < 12;
+		return y < 48 && !bPocket && !bDent;
+	});
+	const VisibilityGraph::ChunkConnectivity arrConnectivity = VisibilityGraph::computeConnectivity(xChunk);
+	check(arrConnectivity[0] == 0, "a solid section connects no faces");
+	check(arrConnectivity[1] == 0, "an enclosed pocket of air connects no faces");
+	check(arrConnectivity[2] == 0, "air touching only the top face connects no faces");
+	check(arrConnectivity[3] == VisibilityGraph::k_uiAllConnected, "an empty section connects all faces");
+
+	// from the pocket only the neighbouring sections are reached, they are solid and lead nowhere
+	VisibilityGraph xGraph;
+	traverse(xGraph, glm::ivec3(0, 1, 0), arrConnectivity);
+	check(xGraph.getStatistics().uiVisitedSections == 7, "a sealed section reaches only its six neighbours");
+	check(xGraph.getStatistics().uiReachableChunks == 5, "a sealed section reaches only the adjacent chunks");
+	check(xGraph.isReachable(1, 0) && !xGraph.isReachable(2, 0) && !xGraph.isReachable(1, 1),
+	      "chunks beyond the neighbours of a sealed section are hidden");
+}
+
+/**
+ * A tunnel along x connects the right and the left face only, and leads the traversal along x to the border
+ */
+static void testTunnelSection()
+{
+	// solid below the surface, with a tunnel along x through section 1
+	const Chunk xChunk = makeChunk([](const int, const int y, const int z) {
+		const bool bTunnel = y >= 20 && y < 24 && z >= 6 && z < 10;
+		return y < 48 && !bTunnel;
+	});
+	const VisibilityGraph::ChunkConnectivity arrConnectivity = VisibilityGraph::computeConnectivity(xChunk);
+	const VisibilityGraph::Connectivity uiTunnel = arrConnectivity[1];
+	check(VisibilityGraph::isConnected(uiTunnel, 2, 3), "the tunnel connects the right and the left face");
+	check(VisibilityGraph::isConnected(uiTunnel, 3, 2), "connections are symmetric");
+	for (int iFaceA = 0; iFaceA < 6; iFaceA++)
+	{
+		for (int iFaceB = iFaceA + 1; iFaceB < 6; iFaceB++)
+		{
+			if (iFaceA != 2 || iFaceB != 3)
+			{
+				check(!VisibilityGraph::isConnected(uiTunnel, iFaceA, iFaceB), "the tunnel connects no other faces");
+			}
+		}
+	}
+
+	// every chunk along the tunnel is reached, besides it only the chunks next to the camera
+	VisibilityGraph xGraph;
+	traverse(xGraph, glm::ivec3(0, 1, 0), arrConnectivity);
+	bool bTunnelReached = true;
+	for (int x = -k_iWorldRadius; x < k_iWorldRadius; x++)
+	{
+		bTunnelReached = bTunnelReached && xGraph.isReachable(x, 0);
+	}
+	check(bTunnelReached, "the traversal follows the tunnel to the border in both directions");
+	check(xGraph.getStatistics().uiReachableChunks == 2 * k_iWorldRadius + 2,
+	      "only the tunnel and the chunks next to the camera are reached");
+	check(!xGraph.isReachable(3, 1) && !xGraph.isReachable(0, 2), "chunks beside the tunnel are hidden");
+	check(!xGraph.isReachable(k_iWorldRadius, 0), "chunks outside the rectangle are never reachable");
+}
+
+/**
+ * Leaving the top of the world enters the top sections of all chunks from the sky, even if they are not connected
+ * horizontally; a camera above the world starts there, a camera below the world hides nothing
+ */
+static void testSkyReentry()
+{
+	// solid up to the top of the world, with a shaft open to the sky in the top section
+	const Chunk xChunk = makeChunk([](const int x, const int y, const int z) {
+		const bool bShaft = y >= 52 && x >= 6 && x < 10 && z >= 6 && z < 10;
+		return !bShaft;
+	});
+	const VisibilityGraph::ChunkConnectivity arrConnectivity = VisibilityGraph::computeConnectivity(xChunk);
+	check(arrConnectivity[SECTION_COUNT - 1] == 0, "the shaft touches the top face only");
+
+	const std::size_t uiChunks = static_cast<std::size_t>(4 * k_iWorldRadius * k_iWorldRadius);
+	VisibilityGraph xGraph;
+	traverse(xGraph, glm::ivec3(0, SECTION_COUNT - 1, 0), arrConnectivity);
+	check(xGraph.getStatistics().uiReachableChunks == uiChunks, "the sky leads from the shaft to every chunk");
+	// the top sections of all chunks and the section below the camera
+	check(xGraph.getStatistics().uiVisitedSections == uiChunks + 1,
+	      "sections entered from the sky lead nowhere without connected faces");
+
+	traverse(xGraph, glm::ivec3(2, SECTION_COUNT, -3), arrConnectivity);
+	check(xGraph.getStatistics().uiVisitedSections == uiChunks, "a camera above the world sees the top sections");
+
+	traverse(xGraph, glm::ivec3(2, -1, -3), arrConnectivity);
+	check(xGraph.getStatistics().uiVisitedSections == uiChunks * SECTION_COUNT,
+	      "a camera below the world hides nothing");
+
+	// the shaft does not reach down to the section below, so the sky is not reached from there
+	traverse(xGraph, glm::ivec3(0, SECTION_COUNT - 2, 0), arrConnectivity);
+	check(xGraph.getStatistics().uiReachableChunks == 5, "a closed top section does not lead to the sky");
+}
+
+/**
+ * Checks VisibilityGraph on synthetic chunks without a GL context
+ *
+ * @return EXIT_FAILURE if any check failed
+ */
+int main()
+{
+	testPairBits();
+	testSealedSection();
+	testTunnelSection();
+	testSkyReentry();
+	if (s_iFailures > 0)
+	{
+		std::printf("%d checks failed\n", s_iFailures);
+		return EXIT_FAILURE;
+	}
+	std::printf("all checks passed\n");
+	return EXIT_SUCCESS;
+}